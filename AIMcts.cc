@@ -0,0 +1,361 @@
+#include "Player.hh"
+
+#include <chrono>
+#include <cmath>
+
+
+/**
+ * Write the name of your player and save this file
+ * with the same name and .cc extension.
+ */
+#define PLAYER_NAME Mcts
+
+
+/**
+ * Monte Carlo tree search over the movements of all the units of the player.
+ *
+ * Every node of the tree is a list of movements of the units of the player
+ * in a round, and its children are lists for the next round. The tree is
+ * open loop: every iteration plays the rounds again from the current board
+ * with the simulator, so the random outcomes of the rounds are sampled too.
+ * The other players, and this one after the tree, follow a quick policy
+ * with rules similar to Nil18's. A node with n visits has up to
+ * 1 + n^WIDENING children: the first one is the policy, and every other
+ * one the policy with some units moved at random.
+ *
+ * The search does a number of iterations set by the cpu time left (see
+ * iterations()) and plays the most visited child of the root. Its random
+ * draws come from a generator of its own, seeded every round from round()
+ * and one draw of the player's generator. Without a time limit the number
+ * of iterations is fixed, so games with this player can be reproduced (and
+ * resumed) exactly; with one, two runs play the same moves as long as the
+ * time measured gives them the same numbers of iterations. The time of a
+ * round is only a safety cap, MAX_TIME scaled down as status() grows, that
+ * should never be reached. It is a baseline that gets better as the
+ * simulator gets faster.
+ */
+struct PLAYER_NAME : public Player {
+
+  /**
+   * Factory: returns a new instance of this class.
+   * Do not modify this function.
+   */
+  static Player* factory () {
+    return new PLAYER_NAME;
+  }
+
+  /**
+   * Types and attributes for your player can be defined here.
+   */
+
+  typedef chrono::steady_clock Clock;
+
+  // Search.
+  const int ITERATIONS = 40;         // Per round, when on pace.
+  const double MIN_SCALE = 0.25;     // Bounds of the scale of ITERATIONS.
+  const double MAX_SCALE = 16;
+  const int PLAN_ROUNDS = 50;        // Rounds between changes of budget.
+  const double MAX_TIME = 0.2;       // Safety cap, in seconds per round.
+  const double MAX_STATUS = 0.8;     // Above this, no search at all.
+  const int DEPTH = 2;               // Rounds in the tree.
+  const int ROLLOUT = 2;             // Rounds played after the tree.
+  const double EXPLORATION = 0.5;
+  const double WIDENING = 0.5;
+  const int DEVIATION = 20;          // Percent of units moved at random.
+
+  // Evaluation.
+  const int CITY_WEIGHT = 8;         // Rounds of score of a city.
+  const int WARRIOR_WEIGHT = 2;      // Score of a warrior.
+  const double SCALE = 10;           // Gain that is worth about 3/4 of a win.
+
+  // Policy.
+  const int MIN_WATER = 15;
+  const int MIN_FUEL = 30;
+
+  struct Node {
+    vector<Movement> moves;   // Movements of the player in its round.
+    vector<int> children;
+    int visits;
+    double value;             // Sum of the values of the visits.
+
+    Node () : visits(0), value(0) { }
+  };
+
+  vector<Node> tree;
+  vector<Action> actions;
+  unsigned search_seed;
+  int budget;               // Iterations per round, see iterations().
+
+  /**
+   * Returns a random integer in [0..n-1] from the generator of the search.
+   */
+  int draw (int n) {
+    search_seed = 1103515245u*search_seed + 12345u;
+    return (search_seed >> 8)%n;
+  }
+
+  /**
+   * Returns a random direction among those of the mask of legal moves.
+   */
+  Dir random_move(int mask) {
+    int n = __builtin_popcount(mask);
+    int k = draw(n);
+    for (int d = 0; d < DirSize; ++d)
+      if ((mask >> d) & 1 and k-- == 0) return Dir(d);
+    return None;
+  }
+
+  /**
+   * Policy of a warrior: attacks a weaker adjacent enemy warrior, or moves
+   * closer to water when thirsty and to a city otherwise, avoiding cars.
+   */
+  Dir warrior_move(const Info& s, int id, int deviation) {
+    const Unit& u = s.unit_ref(id);
+    int mask = s.legal_moves(id);
+    if (draw(100) < deviation) return random_move(mask);
+
+    Pos p = u.pos;
+    int health = min(u.food, u.water);
+    for (int d = 0; d < 8; ++d) {
+      if (not ((mask >> d) & 1)) continue;
+      const Cell& c = s.cell_ref(p + Dir(d));
+      if (c.id == -1) continue;
+      const Unit& v = s.unit_ref(c.id);
+      if (v.player != u.player and v.type == Warrior and min(v.food, v.water) < health)
+        return Dir(d);
+    }
+
+    CellType t = (u.water < MIN_WATER ? Water : City);
+    if (t == City and s.cell_ref(p).type == City) return None;
+    const vector<int>& field = s.distance_field(t, Warrior);
+    Dir best = None;
+    int best_dist = field[p.i*s.cols() + p.j];
+    for (int d = 0; d < 8; ++d) {
+      if (not ((mask >> d) & 1)) continue;
+      Pos q = p + Dir(d);
+      const Cell& c = s.cell_ref(q);
+      if (c.id != -1) continue;
+      if (c.type != City and s.count_in_radius(q, 1, -1, Car) > 0) continue;
+      int dist = field[q.i*s.cols() + q.j];
+      if (dist == -1) continue;
+      if (best_dist == -1 or dist < best_dist or (dist == best_dist and draw(2))) {
+        best = Dir(d);
+        best_dist = dist;
+      }
+    }
+    return best;
+  }
+
+  /**
+   * Policy of a car: goes to a station when low on fuel, runs over an
+   * adjacent enemy warrior, or moves closer to the closest one.
+   */
+  Dir car_move(const Info& s, int id, int deviation) {
+    const Unit& u = s.unit_ref(id);
+    int mask = s.legal_moves(id);
+    if (draw(100) < deviation) return random_move(mask);
+
+    Pos p = u.pos;
+    if (u.food < MIN_FUEL) {
+      const vector<int>& field = s.distance_field(Station, Car);
+      Dir best = None;
+      int best_dist = field[p.i*s.cols() + p.j];
+      for (int d = 0; d < 8; ++d) {
+        if (not ((mask >> d) & 1)) continue;
+        Pos q = p + Dir(d);
+        int dist = field[q.i*s.cols() + q.j];
+        if (s.cell_ref(q).id == -1 and dist != -1 and (best_dist == -1 or dist < best_dist)) {
+          best = Dir(d);
+          best_dist = dist;
+        }
+      }
+      return best;
+    }
+
+    for (int d = 0; d < 8; ++d) {
+      if (not ((mask >> d) & 1)) continue;
+      const Cell& c = s.cell_ref(p + Dir(d));
+      if (c.id != -1 and s.unit_ref(c.id).player != u.player
+          and s.unit_ref(c.id).type == Warrior) return Dir(d);
+    }
+
+    Pos target(-1, -1);
+    for (int k = 1; k < s.nb_players(); ++k) {
+      vector<int> v = s.nearest_units(p, 1, (u.player + k)%s.nb_players(), Warrior);
+      if (v.empty()) continue;
+      Pos q = s.unit_ref(v[0]).pos;
+      if (target.i == -1 or distance(p, q) < distance(p, target)) target = q;
+    }
+    if (target.i == -1) return None;
+
+    Dir best = None;
+    int best_dist = distance(p, target);
+    for (int d = 0; d < 8; ++d) {
+      if (not ((mask >> d) & 1)) continue;
+      Pos q = p + Dir(d);
+      if (s.cell_ref(q).id != -1) continue;
+      if (distance(q, target) < best_dist) {
+        best = Dir(d);
+        best_dist = distance(q, target);
+      }
+    }
+    return best;
+  }
+
+  int distance(Pos a, Pos b) {
+    return max(abs(a.i - b.i), abs(a.j - b.j));
+  }
+
+  /**
+   * Stores in moves the movements of the units of player pl on board s,
+   * following the policy with the given deviation.
+   */
+  void policy(const Info& s, int pl, int deviation, vector<Movement>& moves) {
+    moves.clear();
+    for (int id : s.cars(pl))
+      if (s.can_move(id)) moves.push_back(Movement(id, car_move(s, id, deviation)));
+    for (int id : s.warriors(pl))
+      if (s.can_move(id)) moves.push_back(Movement(id, warrior_move(s, id, deviation)));
+  }
+
+  /**
+   * Plays a round from s, with the given movements for this player and the
+   * policy for the others. The movements of units that this player lost
+   * on the way (the tree is open loop) are dropped.
+   */
+  const Info& play_round(const Info& s, const vector<Movement>& mine, int seed) {
+    vector<Movement> moves;
+    actions.assign(s.nb_players(), Action());
+    for (int pl = 0; pl < s.nb_players(); ++pl) {
+      if (pl == me()) moves = mine;
+      else policy(s, pl, 0, moves);
+      for (const Movement& m : moves)
+        if (s.unit_ref(m.id).player == pl) actions[pl].command(m);
+    }
+    return simulator().next(s, actions, seed);
+  }
+
+  /**
+   * Returns how much better this player is than the best of the others.
+   */
+  double advantage(const Info& s) {
+    double best = -1e9, mine = 0;
+    for (int pl = 0; pl < s.nb_players(); ++pl) {
+      double e = s.total_score(pl) + CITY_WEIGHT*s.num_cities(pl)
+               + WARRIOR_WEIGHT*s.warriors(pl).size();
+      if (pl == me()) mine = e;
+      else best = max(best, e);
+    }
+    return mine - best;
+  }
+
+  /**
+   * Returns the child of node to visit: a new one if the node can widen,
+   * or the one with the best upper confidence bound.
+   */
+  int select(int node, const Info& s) {
+    if (tree[node].children.size() < 1 + pow(tree[node].visits, WIDENING)) {
+      Node child;
+      policy(s, me(), tree[node].children.empty() ? 0 : DEVIATION, child.moves);
+      tree.push_back(child);
+      tree[node].children.push_back(tree.size() - 1);
+      return tree.size() - 1;
+    }
+
+    int best = -1;
+    double best_bound = 0;
+    double log_visits = log(tree[node].visits);
+    for (int c : tree[node].children) {
+      const Node& n = tree[c];
+      double bound = n.value/n.visits + EXPLORATION*sqrt(log_visits/n.visits);
+      if (best == -1 or bound > best_bound) {
+        best = c;
+        best_bound = bound;
+      }
+    }
+    return best;
+  }
+
+  /**
+   * One iteration: goes down the tree, adding a node, plays the rollout
+   * and updates the values of the nodes of the path.
+   */
+  void iterate(double base) {
+    int seed = draw(1000000);
+    const Info* s = this;
+    vector<int> path(1, 0);
+    int node = 0;
+    for (int d = 0; d < DEPTH and s->round() < nb_rounds(); ++d) {
+      bool leaf = tree[node].visits == 0;
+      node = select(node, *s);
+      path.push_back(node);
+      s = &play_round(*s, tree[node].moves, seed + d);
+      if (leaf or tree[node].visits == 0) break;
+    }
+
+    vector<Movement> moves;
+    for (int r = 0; r < ROLLOUT and s->round() < nb_rounds(); ++r) {
+      policy(*s, me(), 0, moves);
+      s = &play_round(*s, moves, seed + DEPTH + r);
+    }
+
+    double value = 0.5 + 0.5*tanh((advantage(*s) - base)/SCALE);
+    for (int k : path) {
+      ++tree[k].visits;
+      tree[k].value += value;
+    }
+  }
+
+  /**
+   * Returns the iterations of the search for the next rounds: ITERATIONS,
+   * scaled by the fraction of the cpu time left (1 - status()) over the
+   * fraction of the game left, so that a player that has used less than
+   * its share searches more, and one that has used more searches less.
+   * The scale is rounded to a power of 2, and only set again every
+   * PLAN_ROUNDS rounds, so that the differences in the time measured from
+   * one run to another seldom change the count. Without a time limit
+   * status() is always 0, there is no share to keep to, and the count is
+   * ITERATIONS in every run.
+   */
+  int iterations () {
+    if (status(me()) <= 0) return ITERATIONS;
+    double game_left = double(nb_rounds() - round())/nb_rounds();
+    double scale = (1 - status(me()))/game_left;
+    scale = min(MAX_SCALE, max(MIN_SCALE, exp2(floor(log2(scale) + 0.5))));
+    return max(1, int(ITERATIONS*scale));
+  }
+
+  /**
+   * Play method, invoked once per each round.
+   */
+  virtual void play () {
+    search_seed = 1000003u*round() + random(0, 999999);
+    if (first_play() or round()%PLAN_ROUNDS == 0) budget = iterations();
+    vector<Movement> moves;
+    if (status(me()) > MAX_STATUS) policy(*this, me(), 0, moves);
+    else {
+      Clock::time_point t0 = Clock::now();
+      double cap = MAX_TIME*(1 - max(0.0, status(me())));
+      tree.assign(1, Node());
+      double base = advantage(*this);
+      for (int it = 0; it < budget; ++it) {
+        if (it > 0 and chrono::duration<double>(Clock::now() - t0).count() > cap) break;
+        iterate(base);
+      }
+
+      int best = -1;
+      for (int c : tree[0].children)
+        if (best == -1 or tree[c].visits > tree[best].visits) best = c;
+      if (best == -1) policy(*this, me(), 0, moves);
+      else moves = tree[best].moves;
+    }
+    for (const Movement& m : moves) command(m);
+  }
+
+};
+
+
+/**
+ * Do not modify the following line.
+ */
+RegisterPlayer(PLAYER_NAME);
@@ -193,7 +193,7 @@ struct PLAYER_NAME : public Player {
     */
     virtual void play () {
         //Preliminars
-        if (round() == 0) initialize_cities();
+        if (first_play()) initialize_cities();
         my_warriors = warriors(me());
         my_cars = cars(me());
         already_moved = SP();
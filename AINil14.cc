@@ -894,7 +894,7 @@ struct PLAYER_NAME : public Player {
     */
     virtual void play () {
         //Preliminars ronda 0
-        if (round() == 0) {
+        if (first_play()) {
             initialize_cities();
             initialize_distances();
             initialize_map();
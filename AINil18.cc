@@ -69,19 +69,20 @@ struct PLAYER_NAME : public Player {
     SP already_moved;
     SP already_attacked;
     VVP all_cities;
+    Grid<int> city_index; //Index a all_cities de la ciutat de cada casella, o -1
     VI allies_in_city;
     VI enemies_in_city;
     VI allies_entering_city;
     VI allies_leaving_city;
     VI city_owner;
-    VVI car_map;
-    VVI warrior_map;
-    VVI distance_from_water;
-    VVI distance_from_fuel_weighted;
-    VVI distance_from_fuel_not_weighted;
-    VVI distance_from_city;
-    VVI distance_from_road;
-    VVI distance_from_enemy_car;
+    Grid<int> car_map;
+    Grid<int> warrior_map;
+    Grid<int> distance_from_water;
+    Grid<int> distance_from_fuel_weighted;
+    Grid<int> distance_from_fuel_not_weighted;
+    Grid<int> distance_from_city;
+    Grid<int> distance_from_road;
+    Arena_grid<int> distance_from_enemy_car; //In the arena of the round
 
     template<typename T>
     class CompPairIP {
@@ -106,7 +107,7 @@ struct PLAYER_NAME : public Player {
     */
     int cell_unit(const Cell& c) {
         if (c.id == -1) return 0;
-        Unit u = unit(c.id);
+        const Unit& u = unit_ref(c.id);
         if (u.player == me() and u.type == Warrior) return 1;
         if (u.player == me() and u.type == Car) return 2;
         if (u.type == Warrior) return 3;
@@ -120,23 +121,21 @@ struct PLAYER_NAME : public Player {
     
     int enemy_cars_around(const Pos& p) {
         int count = 0;
-        for (int i = 0; i < (int)enemy_cars.size(); i++) {
-            Pos enemy = unit(enemy_cars[i]).pos;
-            int dist = distance(p, enemy);
-            if (distance(p, enemy) <= ENEMY_CAR_RANGE) count += 5*(ENEMY_CAR_RANGE-dist);
+        for (int k = 1; k < 4; k++) {
+            for_each_in_radius(p, ENEMY_CAR_RANGE, (me()+k)%4, Car, [&](Pos q) {
+                count += 5*(ENEMY_CAR_RANGE-distance(p, q));
+            });
         }
         return count;
     }
     
     int enemy_warriors_around(const Pos& p) {
         int count = 0;
-        for (int i = -ACCUMULATION_RADIUS; i <= ACCUMULATION_RADIUS; i++) {
-            for (int j = -ACCUMULATION_RADIUS; j <= ACCUMULATION_RADIUS; j++) {
-                Pos curr = Pos(p.i+i, p.j+j);
-                if (not pos_ok(curr)) continue;
-                int weight = (5 - distance_from_road[curr.i][curr.j]);;
-                if (pos_ok(curr) and cell_unit(cell(curr)) == 3) count += (cell(curr).type == City ? 1 : weight);
-            }
+        for (int k = 1; k < 4; k++) {
+            for_each_in_radius(p, ACCUMULATION_RADIUS, (me()+k)%4, Warrior, [&](Pos q) {
+                int weight = (5 - distance_from_road[q.i][q.j]);
+                count += (cell_ref(q).type == City ? 1 : weight);
+            });
         }
         return count;
     }
@@ -147,15 +146,11 @@ struct PLAYER_NAME : public Player {
     }
     
     bool car_can_go(const Pos& p) {
-        if (not pos_ok(p)) return false;
-        Cell c = cell(p);
-        return (c.type == Road or c.type == Desert);
+        return can_stand(p, Car);
     }
     
     bool warrior_can_go(const Pos& p) {
-        if (not pos_ok(p)) return false;
-        Cell c = cell(p);
-        return (c.type == Road or c.type == Desert or c.type == City);
+        return can_stand(p, Warrior);
     }
     
     bool can_go(const Pos& p, bool car) {
@@ -220,12 +215,12 @@ struct PLAYER_NAME : public Player {
         if (not car and not warrior_can_go(p)) return false;
         
         //No friendly unit there
-        if (is_friendly(cell(p))) return false;
+        if (is_friendly(cell_ref(p))) return false;
         if (already_moved.count(p)) return false;
         
         //No car in the immediate surroundings
         if (car and distance_from_enemy_car[p.i][p.j] < 2) return false;
-        if (cell(p).type != City and not car and distance_from_enemy_car[p.i][p.j] < INF) return false;
+        if (cell_ref(p).type != City and not car and distance_from_enemy_car[p.i][p.j] < INF) return false;
         
         return true;
     }
@@ -236,7 +231,7 @@ struct PLAYER_NAME : public Player {
         if (not warrior_can_go(p)) return false;
         
         //No friendly unit there
-        if (is_friendly(cell(p))) return false;
+        if (is_friendly(cell_ref(p))) return false;
         if (already_moved.count(p)) return false;
         
         return true;
@@ -274,68 +269,41 @@ struct PLAYER_NAME : public Player {
     
     //Busca el soldat enemic mes proper / mes beneficios i troba la direccio apropiada per aproparse
     Dir dijkstra(const Pos& start) {
-        priority_queue<IP, vector<IP>, CompPairIP<IP>> PQ;
-        VVI distances(60, VI(60, INF));
-        PQ.push(make_pair(0, start));
-        distances[start.i][start.j] = 0;
-        bool cont = true;
-        
         Pos best(-1, -1);
         int best_acc = 0;
+        Path_finder& pf = paths();
         
-        map<Pos, Pos> pare;
-        pare[start] = start;
+        auto step_cost = [&](const Pos& p, const Pos& p2) {
+            if (not is_safe(p2, true) and distance(start, p2) <= 2) return -1;
+            int cost = (cell_ref(p).type == Road ? 1 : 4);
+            if (cell_ref(start).type == Road and pf.parent(p) == start) {
+                int my = me();
+                int r = (round()+1)%4;
+                if (r == my) cost = 1;
+            }
+            return cost;
+        };
         
-        while (not PQ.empty()) {
-            Pos p = PQ.top().second;
-            int dist = PQ.top().first; 
-            PQ.pop();
-            if (dist == distances[p.i][p.j]) {
-                if (cell_unit(cell(p)) == 3 and not already_attacked_near(p)) {
-                    int curr_acc = enemy_warriors_around(p);
-                    if (distance_from_road[p.i][p.j] < MAX_DIST_ROAD) {
-                        if (not pos_ok(best) or is_better(dist, curr_acc, distances[best.i][best.j], best_acc)) {
-                            best_acc = curr_acc;
-                            best = p;
-                        }
-                    }
-                }
-                
-                int cost = (cell(p).type == Road ? 1 : 4);
-                if (cell(start).type == Road and pare[p] == start) {
-                    int my = me();
-                    int r = (round()+1)%4;
-                    if (r == my) cost = 1;
-                }
-                for (int i = 0; i < 8; i++) {
-                    Dir d = Dir(i);
-                    Pos p2 = p+d;
-                    int curr_dist = dist + cost;
-                    if (pos_ok(p2) and car_can_go(p2) and curr_dist < CAR_RANGE and (is_safe(p2, true) or distance(start, p2) > 2)) {
-                        if (curr_dist < distances[p2.i][p2.j]) {
-                            PQ.push(make_pair(curr_dist, p2));
-                            distances[p2.i][p2.j] = curr_dist;
-                            pare[p2] = p;
-                        }
+        auto visit = [&](const Pos& p, int dist) {
+            if (cell_unit(cell_ref(p)) == 3 and not already_attacked_near(p)) {
+                int curr_acc = enemy_warriors_around(p);
+                if (distance_from_road[p.i][p.j] < MAX_DIST_ROAD) {
+                    if (not pos_ok(best) or is_better(dist, curr_acc, pf.distance(best), best_acc)) {
+                        best_acc = curr_acc;
+                        best = p;
                     }
                 }
             }
-        }
+            return false;
+        };
+        
+        pf.dial(start, Car, step_cost, visit, 4, CAR_RANGE);
         if (not pos_ok(best)) return None;
         
         already_attacked.insert(best);
-        Pos p = best;
-        while (pare[p] != start) {
-            p = pare[p];
-        }
-
-        for (int i = 0; i < 8; i++) {
-            Dir d = Dir(i);
-            if (start+d == p) return d;
-        }
-        return None;
+        return pf.first_step(best);
     }
-
+    
     //Hauria de retornar una pos i despres fer bfs o dijkstra alli
     Dir find_city_to_conquer(const Pos& start) {
         int min_dist = INF;
@@ -459,57 +427,22 @@ struct PLAYER_NAME : public Player {
         return best_pos;
     }
     
-    void bfs_water(const Pos& start) {
-        VVI used(60, VI(60, false));
+    void bfs_fuel_weighted() {
         queue<pair<int, Pos>> Q;
-        Q.push(make_pair(0, start));
-        used[start.i][start.j] = true;
-        while (not Q.empty()) {
-            Pos p = Q.front().second;
-            int dist = Q.front().first;
-            Q.pop();
-            distance_from_water[p.i][p.j] = min(distance_from_water[p.i][p.j], dist);
-            for (int i = 0; i < 8; i++) {
-                Dir d = Dir(i);
-                Pos p2 = p+d;
-                if (pos_ok(p2) and warrior_can_go(p2) and not used[p2.i][p2.j]) {
-                    Q.push(make_pair(dist+1, p2));
-                    used[p2.i][p2.j] = true;
-                }
-            }
-        }
-    }
-    
-    void bfs_city(const Pos& start) {
-        VVI used(60, VI(60, false));
-        queue<pair<int, Pos>> Q;
-        Q.push(make_pair(0, start));
-        used[start.i][start.j] = true;
-        while (not Q.empty()) {
-            Pos p = Q.front().second;
-            int dist = Q.front().first;
-            Q.pop();
-            distance_from_city[p.i][p.j] = min(distance_from_city[p.i][p.j], dist);
-            for (int i = 0; i < 8; i++) {
-                Dir d = Dir(i);
-                Pos p2 = p+d;
-                if (pos_ok(p2) and warrior_can_go(p2) and not used[p2.i][p2.j]) {
-                    Q.push(make_pair(dist+1, p2));
-                    used[p2.i][p2.j] = true;
+        for (int i = 0; i < 60; i++) {
+            for (int j = 0; j < 60; j++) {
+                if (cell_ref(i, j).type == Station) {
+                    Q.push(make_pair(0, Pos(i, j)));
+                    distance_from_fuel_weighted[i][j] = 0;
                 }
             }
         }
-    }
-    
-    void bfs_fuel_weighted(const Pos& start) {
-        queue<pair<int, Pos>> Q;
-        Q.push(make_pair(0, start));
-        distance_from_fuel_weighted[start.i][start.j] = 0;
         while (not Q.empty()) {
             Pos p = Q.front().second;
             int dist = Q.front().first;
             Q.pop();
-            int cost = (cell(p).type == Road ? 1 : 4);
+            if (dist > distance_from_fuel_weighted[p.i][p.j]) continue;
+            int cost = (cell_ref(p).type == Road ? 1 : 4);
             for (int i = 0; i < 8; i++) {
                 Dir d = Dir(i);
                 Pos p2 = p+d;
@@ -521,75 +454,33 @@ struct PLAYER_NAME : public Player {
         }
     }
     
-    void bfs_fuel_not_weighted(const Pos& start) {
-        VVI used(60, VI(60, false));
-        queue<pair<int, Pos>> Q;
-        Q.push(make_pair(0, start));
-        used[start.i][start.j] = true;
-        while (not Q.empty()) {
-            Pos p = Q.front().second;
-            int dist = Q.front().first;
-            Q.pop();
-            distance_from_fuel_not_weighted[p.i][p.j] = min(distance_from_fuel_not_weighted[p.i][p.j], dist);
-            for (int i = 0; i < 8; i++) {
-                Dir d = Dir(i);
-                Pos p2 = p+d;
-                if (pos_ok(p2) and car_can_go(p2) and not used[p2.i][p2.j]) {
-                    Q.push(make_pair(dist+1, p2));
-                    used[p2.i][p2.j] = true;
-                }
-            }
-        }
-    }
-    
-    void bfs_road(const Pos& start) {
-        VVI used(60, VI(60, false));
-        queue<pair<int, Pos>> Q;
-        Q.push(make_pair(0, start));
-        used[start.i][start.j] = true;
-        while (not Q.empty()) {
-            Pos p = Q.front().second;
-            int dist = Q.front().first;
-            Q.pop();
-            distance_from_road[p.i][p.j] = min(distance_from_road[p.i][p.j], dist);
-            for (int i = 0; i < 8; i++) {
-                Dir d = Dir(i);
-                Pos p2 = p+d;
-                if (pos_ok(p2) and car_can_go(p2) and not used[p2.i][p2.j]) {
-                    Q.push(make_pair(dist+1, p2));
-                    used[p2.i][p2.j] = true;
-                }
+    //Copies a distance field of the engine, with INF for unreachable cells
+    Grid<int> distance_field_to(CellType t, UnitType u) {
+        const VI& field = distance_field(t, u);
+        Grid<int> dist(60, 60);
+        for (int i = 0; i < 60; i++) {
+            for (int j = 0; j < 60; j++) {
+                int d = field[i*60 + j];
+                dist[i][j] = (d == -1 ? INF : d);
             }
         }
+        return dist;
     }
     
     void initialize_distances() {
-        distance_from_water = distance_from_fuel_weighted = distance_from_fuel_not_weighted = distance_from_city = distance_from_road = VVI(60, VI(60, INF));
-        for (int i = 0; i < 60; i++) {
-            for (int j = 0; j < 60; j++) {
-                Cell c = cell(i, j);
-                if (c.type == Water) {
-                    bfs_water(Pos(i, j));
-                }
-                else if (c.type == Station) {
-                    bfs_fuel_not_weighted(Pos(i, j));
-                    bfs_fuel_weighted(Pos(i, j));
-                }
-                else if (c.type == City) {
-                    bfs_city(Pos(i, j));
-                }
-                else if (c.type == Road) {
-                    bfs_road(Pos(i, j));
-                }
-            }
-        }
+        distance_from_water = distance_field_to(Water, Warrior);
+        distance_from_city = distance_field_to(City, Warrior);
+        distance_from_road = distance_field_to(Road, Car);
+        distance_from_fuel_not_weighted = distance_field_to(Station, Car);
+        distance_from_fuel_weighted = Grid<int>(60, 60, INF);
+        bfs_fuel_weighted();
     }
     
     VI initialize_enemy_warriors() {
         VI v(80 - my_warriors.size());
         int j = 0;
         for (int i = 1; i < 4; i++) {
-            VI v2 = warriors((me()+i)%4);
+            const VI& v2 = warriors((me()+i)%4);
             for (int k = 0; k < (int)v2.size(); k++) {
                 v[j] = v2[k];
                 j++;
@@ -602,7 +493,7 @@ struct PLAYER_NAME : public Player {
         VI v(12 - my_cars.size());
         int j = 0;
         for (int i = 1; i < 4; i++) {
-            VI v2 = cars((me()+i)%4);
+            const VI& v2 = cars((me()+i)%4);
             for (int k = 0; k < (int)v2.size(); k++) {
                 v[j] = v2[k];
                 j++;
@@ -614,8 +505,9 @@ struct PLAYER_NAME : public Player {
     void initialize_distances_to_cars() {
         int RANGE = ENEMY_CAR_RANGE;
         if (round()%4 != me()) RANGE = 3;
-        distance_from_enemy_car = VVI(60, VI(60, INF));
-        queue<IP> Q;
+        distance_from_enemy_car = Arena_grid<int>(arena(), 60, 60, INF);
+        typedef deque<IP, Arena_allocator<IP>> DIP;
+        queue<IP, DIP> Q{DIP(arena())};
         for (int i = 0; i < (int)enemy_cars.size(); i++) {
             Pos car = unit(enemy_cars[i]).pos;
             Q.push(IP(0, car));
@@ -669,69 +561,66 @@ struct PLAYER_NAME : public Player {
                 }
             }
         }
+        city_index = Grid<int>(60, 60, -1);
+        for (int i = 0; i < (int)all_cities.size(); i++) {
+            for (Pos p : all_cities[i]) city_index[p] = i;
+        }
     }
     
     void initialize_city_stats() {
         num_cities_owned = 0;
-        city_owner = VI(8, false);
-        allies_in_city = VI(8, 0);
-        enemies_in_city = VI(8, 0);
-        allies_entering_city = VI(8, 0);
-        allies_leaving_city = VI(8, 0);
-        for (int i = 0; i < (int)all_cities.size(); i++) {
+        int n = all_cities.size();
+        city_owner = VI(n, false);
+        allies_in_city = VI(n, 0);
+        enemies_in_city = VI(n, 0);
+        allies_entering_city = VI(n, 0);
+        allies_leaving_city = VI(n, 0);
+        for (int i = 0; i < n; i++) {
             if (cell(all_cities[i][0]).owner == me()) {
                 city_owner[i] = true;
                 num_cities_owned++;
             }
-            for (int j = 0; j < (int)all_cities[i].size(); j++) {
-                int u = cell_unit(cell(all_cities[i][j]));
-                if (u == 1) allies_in_city[i]++;
-                else if (u == 3) enemies_in_city[i]++;
+        }
+        //Les ciutats de all_cities poden no ser les de cities() (veins en diagonal)
+        for (int pl = 0; pl < 4; pl++) {
+            for (int id : warriors(pl)) {
+                int i = city_index[unit_ref(id).pos];
+                if (i == -1) continue;
+                if (pl == me()) allies_in_city[i]++;
+                else enemies_in_city[i]++;
             }
         }
     }
     
+    //Calcula els mapes de puntuacio a partir de capes amb les distancies
     void initialize_map() {
-        warrior_map = car_map = VVI(60, VI(60, 0));
+        Grid<int> in_city(60, 60), from_center(60, 60), warrior_ok(60, 60), car_ok(60, 60);
         for (int i = 0; i < 60; i++) {
             for (int j = 0; j < 60; j++) {
                 Pos here = Pos(i, j);
-                Cell p = cell(here);
-                int& w = warrior_map[i][j];
-                int& c = car_map[i][j];
-                
-                int dist_city = distance_from_city[i][j];
-                int dist_fuel = distance_from_fuel_weighted[i][j];
-                int dist_water = distance_from_water[i][j];
-                int dist_road = distance_from_road[i][j];
-                
-                if (not warrior_can_go(here)) w = -1;
-                else {
-                    if (p.type == City) w += 50;
-                    if (dist_water < 8) w += 20-dist_water;
-                    if (dist_city < 8) w += 20-dist_city;
-                    if (dist_water + dist_city < 12) w += 50;
-                }
-                
-                if (not car_can_go(here)) c = -1;
-                else {
-                    c += 100*(5 - dist_road);
-                    if (dist_water + dist_city < 16) c += 100;
-                    c += (30-distance(here, Pos(30, 30)));
-                }
+                in_city[i][j] = (cell_ref(here).type == City);
+                from_center[i][j] = distance(here, Pos(30, 30));
+                warrior_ok[i][j] = warrior_can_go(here);
+                car_ok[i][j] = car_can_go(here);
             }
         }
+        
+        //Capes: 0 ciutat, 1 aigua, 2 distancia a ciutat, 3 carretera, 4 centre, 5 i 6 on es pot anar
+        vector<const Grid<int>*> layers = {&in_city, &distance_from_water, &distance_from_city,
+                                           &distance_from_road, &from_center, &warrior_ok, &car_ok};
+        evaluate(layers, {{0, -1, INT_MAX, 0, 50},
+                          {1, -1, 8, 20, -1},
+                          {2, -1, 8, 20, -1},
+                          {1, 2, 12, 50, 0}}, 5, warrior_map);
+        evaluate(layers, {{3, -1, INT_MAX, 500, -100},
+                          {1, 2, 16, 100, 0},
+                          {4, -1, INT_MAX, 30, -1}}, 6, car_map);
     }
     
     //pre: p is in a city
-    //returns number 0-7 with the number of the city it belongs to
+    //returns the index in all_cities of the city it belongs to
     int num_city(const Pos& p) {
-        for (int i = 0; i < (int)all_cities.size(); i++) {
-            for (int j = 0; j < (int)all_cities[i].size(); j++) {
-                if (p == all_cities[i][j]) return i;
-            }
-        }
-        return -1;
+        return city_index[p];
     }
     
     bool calculate_aggressive() {
@@ -992,7 +881,7 @@ struct PLAYER_NAME : public Player {
     */
     virtual void play () {
         //Preliminars ronda 0
-        if (round() == 0) {
+        if (first_play()) {
             initialize_cities();
             initialize_distances();
             initialize_map();
@@ -3,6 +3,7 @@
 
 
 #include "Structs.hh"
+#include "Log.hh"
 
 
 /**
@@ -108,7 +109,7 @@ public:
     _my_assert(++q_ <= MAX_MOVEMENTS, "Too many commands.");
 
     if (u_.find(m.id) != u_.end()) {
-      cerr << "warning: action already requested for unit " << m.id << endl;
+      _log_warning(LogAction, "action already requested for unit " << m.id);
       return;
     }
 
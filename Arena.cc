@@ -0,0 +1,30 @@
+#include "Arena.hh"
+
+
+Arena::~Arena () {
+  for (char* b : blocks_) delete[] b;
+}
+
+
+void* Arena::next_block (size_t bytes, size_t align) {
+  // Blocks after the current one are reused if they are large enough,
+  // otherwise a new one is inserted, twice as large as the last.
+  if (not blocks_.empty()) ++current_;
+  while (current_ < blocks_.size() and sizes_[current_] < bytes + align)
+    ++current_;
+  if (current_ == blocks_.size()) {
+    size_t size = max(blocks_.empty() ? BLOCK : 2*sizes_.back(), bytes + align);
+    blocks_.push_back(new char[size]);
+    sizes_.push_back(size);
+  }
+  ptr_ = blocks_[current_];
+  end_ = ptr_ + sizes_[current_];
+  return allocate(bytes, align);
+}
+
+
+size_t Arena::capacity () const {
+  size_t size = 0;
+  for (size_t s : sizes_) size += s;
+  return size;
+}
@@ -0,0 +1,165 @@
+#ifndef Arena_hh
+#define Arena_hh
+
+
+#include "Structs.hh"
+
+#include <cstddef>
+#include <type_traits>
+
+
+/** \file
+ * Contains a bump allocator for the data of a round, with adapters for the
+ * containers of the standard library and a 2D grid on top of it.
+ */
+
+
+/**
+ * Hands out memory from a few large blocks, and frees all of it at once.
+ *
+ * Allocating is a pointer increment, freeing a single object does nothing,
+ * and clear() frees everything in O(1), keeping the blocks for the next
+ * use: once the blocks are large enough, no memory is asked to the system.
+ * Destructors are never run, and all the memory given out becomes invalid
+ * with clear().
+ */
+class Arena {
+
+  static const size_t BLOCK = 1 << 16;  // Size of the first block.
+
+  vector<char*> blocks_;
+  vector<size_t> sizes_;
+  size_t current_;  // Block in use.
+  char* ptr_;       // First free byte of the block in use.
+  char* end_;       // End of the block in use.
+
+  /**
+   * Moves to the next block with at least bytes bytes, and allocates there.
+   */
+  void* next_block (size_t bytes, size_t align);
+
+public:
+
+  Arena () : current_(0), ptr_(0), end_(0) { }
+
+  ~Arena ();
+
+  Arena (const Arena&) = delete;
+  Arena& operator= (const Arena&) = delete;
+
+  /**
+   * Returns bytes bytes of memory aligned to align (a power of 2).
+   */
+  inline void* allocate (size_t bytes, size_t align) {
+    char* p = (char*)(((size_t)ptr_ + align - 1) & ~(align - 1));
+    if (ptr_ == 0 or p + bytes > end_) return next_block(bytes, align);
+    ptr_ = p + bytes;
+    return p;
+  }
+
+  /**
+   * Frees all the memory given out, keeping the blocks.
+   */
+  inline void clear () {
+    current_ = 0;
+    ptr_ = blocks_.empty() ? 0 : blocks_[0];
+    end_ = blocks_.empty() ? 0 : blocks_[0] + sizes_[0];
+  }
+
+  /**
+   * Returns the total size of the blocks, in bytes.
+   */
+  size_t capacity () const;
+
+};
+
+
+/**
+ * Allocator for the containers of the standard library, taking the memory
+ * from an arena. Vectors should be reserved beforehand, since the memory of
+ * every reallocation is only freed with the arena.
+ */
+template <class T>
+struct Arena_allocator {
+
+  typedef T value_type;
+
+  Arena* arena;
+
+  Arena_allocator (Arena& a) : arena(&a) { }
+
+  template <class U>
+  Arena_allocator (const Arena_allocator<U>& other) : arena(other.arena) { }
+
+  T* allocate (size_t n) {
+    return (T*)arena->allocate(n*sizeof(T), alignof(T));
+  }
+
+  void deallocate (T*, size_t) { }
+
+};
+
+template <class T, class U>
+inline bool operator== (const Arena_allocator<T>& a, const Arena_allocator<U>& b) {
+  return a.arena == b.arena;
+}
+
+template <class T, class U>
+inline bool operator!= (const Arena_allocator<T>& a, const Arena_allocator<U>& b) {
+  return a.arena != b.arena;
+}
+
+
+/**
+ * A vector in an arena.
+ */
+template <class T>
+using Arena_vector = vector<T, Arena_allocator<T> >;
+
+
+/**
+ * A grid of rows*cols elements in an arena, row by row, indexed as g[i][j]
+ * or g[p]. Copies share the same elements. Only for types with trivial
+ * destructors, since the arena never runs them.
+ */
+template <class T>
+class Arena_grid {
+
+  static_assert(is_trivially_destructible<T>::value,
+                "The arena never destroys the elements of a grid.");
+
+  T* data_;
+  int rows_;
+  int cols_;
+
+public:
+
+  /**
+   * Empty grid.
+   */
+  Arena_grid () : data_(0), rows_(0), cols_(0) { }
+
+  /**
+   * Grid of rows*cols copies of value, in arena.
+   */
+  Arena_grid (Arena& arena, int rows, int cols, const T& value = T())
+    : data_((T*)arena.allocate(rows*cols*sizeof(T), alignof(T))),
+      rows_(rows), cols_(cols) {
+    fill(data_, data_ + rows*cols, value);
+  }
+
+  inline int rows () const { return rows_; }
+  inline int cols () const { return cols_; }
+  inline T* data () { return data_; }
+  inline const T* data () const { return data_; }
+
+  inline T* operator[] (int i) { return data_ + i*cols_; }
+  inline const T* operator[] (int i) const { return data_ + i*cols_; }
+
+  inline T& operator[] (Pos p) { return data_[p.i*cols_ + p.j]; }
+  inline const T& operator[] (Pos p) const { return data_[p.i*cols_ + p.j]; }
+
+};
+
+
+#endif
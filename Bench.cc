@@ -0,0 +1,598 @@
+#include "Board.hh"
+#include "Player.hh"
+
+#include <chrono>
+
+
+/** \file
+ * Micro-benchmarks of the game engine and of the registered players.
+ */
+
+
+/**
+ * Configuration of the benchmarked games (the same as default.cnf).
+ */
+static const char* CONFIG =
+  "Mad_Max 1.6\n"
+  "nb_players        4\n"
+  "nb_rounds       500\n"
+  "nb_cities         8\n"
+  "nb_warriors      20\n"
+  "nb_cars           3\n"
+  "warriors_health  40\n"
+  "cars_fuel       100\n"
+  "damage            6\n"
+  "rows             60\n"
+  "cols             60\n"
+  "\n"
+  "GENERATOR\n";
+
+
+/**
+ * Runs the benchmarks and prints their results to cout, one tab-separated
+ * line per benchmark: name, unit, samples, median, mean, standard deviation,
+ * minimum and maximum. Lines starting with # are comments.
+ *
+ * Every benchmark uses fixed seeds, so that all its samples (and all the
+ * runs of the same binary) do the same work, and runs once untimed before
+ * sampling, to warm up caches and allocators. Setup is never timed.
+ */
+class Bench {
+
+  typedef chrono::steady_clock Clock;
+
+  static const int SEED = 7;          // Seed of the benchmarked games.
+  static const int ROUNDS = 100;      // Rounds played per sample of next().
+  static const int PLAY_ROUNDS = 50;  // Rounds played per sample of play().
+  static const int MID_ROUND = 50;    // Round of the mid-game board.
+
+  int samples_;
+  string filter_;
+  Board* start_;  // Board at round 0.
+  Board* mid_;    // Board at round MID_ROUND, played at random.
+
+  /**
+   * Returns the nanoseconds elapsed since t0.
+   */
+  static double elapsed (Clock::time_point t0) {
+    return chrono::duration<double, nano>(Clock::now() - t0).count();
+  }
+
+  /**
+   * Commands a random movement to a fraction of the units of every player.
+   */
+  static void random_actions (const Board& b, double fraction,
+                              Random_generator& rnd, vector<Action>& act);
+
+  /**
+   * Plays rounds of random movements with the given fraction of units.
+   * Returns the nanoseconds spent in next().
+   */
+  static double play_random (Board& b, int rounds, double fraction,
+                             Random_generator& rnd);
+
+  /**
+   * The multi-source BFS of the players, with a queue of cells: stores in
+   * dist the distance from the sources through passable cells, or -1.
+   * Compared with bfs_distances.
+   */
+  static void queue_bfs (const Board& b, const vector<Pos>& sources,
+                         UnitType ut, int max_dist, Grid<int>& dist);
+
+  /**
+   * Prints the statistics of the samples x of a benchmark.
+   */
+  void report (const string& name, const string& unit, vector<double> x) const;
+
+  /**
+   * Runs sample (which returns a value in the given unit) once untimed
+   * and samples_ times measured, if name matches the filter.
+   */
+  template <typename F>
+  void measure (const string& name, const string& unit, F sample) const;
+
+  void bench_board ();
+  void bench_next ();
+  void bench_spawn ();
+  void bench_reset ();
+  void bench_print ();
+  void bench_spatial ();
+  void bench_bfs ();
+  void bench_paths ();
+  void bench_eval ();
+  void bench_simulate ();
+  void bench_players ();
+
+public:
+
+  Bench (int samples, string filter);
+
+  ~Bench ();
+
+  /**
+   * Runs all the benchmarks that match the filter.
+   */
+  void run ();
+
+};
+
+
+Bench::Bench (int samples, string filter)
+  : samples_(samples), filter_(filter) {
+  istringstream is(CONFIG);
+  start_ = new Board(is, SEED);
+  mid_ = new Board(*start_);
+  Random_generator rnd;
+  rnd.set_random_seed(SEED);
+  play_random(*mid_, MID_ROUND, 1, rnd);
+}
+
+
+Bench::~Bench () {
+  delete start_;
+  delete mid_;
+}
+
+
+void Bench::random_actions (const Board& b, double fraction,
+                            Random_generator& rnd, vector<Action>& act) {
+  act = vector<Action>(b.nb_players());
+  for (int id = 0; id < b.nb_units(); ++id)
+    if (b.can_move(id) and rnd.random(0, 999) < 1000*fraction)
+      act[b.unit(id).player].command(id, Dir(rnd.random(0, DirSize - 2)));
+}
+
+
+double Bench::play_random (Board& b, int rounds, double fraction,
+                           Random_generator& rnd) {
+  double t = 0;
+  vector<Action> act;
+  vector<Movement> done;
+  for (int r = 0; r < rounds; ++r) {
+    random_actions(b, fraction, rnd, act);
+    Clock::time_point t0 = Clock::now();
+    b.next(act, done);
+    t += elapsed(t0);
+  }
+  return t;
+}
+
+
+void Bench::report (const string& name, const string& unit, vector<double> x) const {
+  int n = x.size();
+  sort(x.begin(), x.end());
+  double median = n%2 ? x[n/2] : (x[n/2 - 1] + x[n/2])/2;
+  double mean = 0;
+  for (double v : x) mean += v;
+  mean /= n;
+  double var = 0;
+  for (double v : x) var += (v - mean)*(v - mean);
+  if (n > 1) var /= n - 1;
+  cout << name << '\t' << unit << '\t' << n << '\t' << median << '\t' << mean
+       << '\t' << sqrt(var) << '\t' << x[0] << '\t' << x[n - 1] << endl;
+}
+
+
+template <typename F>
+void Bench::measure (const string& name, const string& unit, F sample) const {
+  if (name.find(filter_) == string::npos) return;
+  sample();
+  vector<double> x;
+  for (int k = 0; k < samples_; ++k) x.push_back(sample());
+  report(name, unit, x);
+}
+
+
+void Bench::bench_board () {
+  measure("board_generate", "ns/op", [] {
+    const int n = 5;
+    double t = 0;
+    for (int k = 0; k < n; ++k) {
+      istringstream is(CONFIG);
+      Clock::time_point t0 = Clock::now();
+      Board b(is, SEED + k);
+      t += elapsed(t0);
+    }
+    return t/n;
+  });
+}
+
+
+void Bench::bench_next () {
+  const double fractions[] = { 0, 0.5, 1 };
+  const char* names[] = { "next_idle", "next_half", "next_full" };
+  for (int k = 0; k < 3; ++k) {
+    double fraction = fractions[k];
+    const Board& start = *start_;
+    measure(names[k], "ns/round", [&start, fraction] {
+      Board b = start;
+      Random_generator rnd;
+      rnd.set_random_seed(SEED);
+      return play_random(b, ROUNDS, fraction, rnd)/ROUNDS;
+    });
+  }
+}
+
+
+void Bench::bench_spawn () {
+  // Every other unit of the given type dies at once.
+  for (UnitType t : { Warrior, Car }) {
+    const Board& mid = *mid_;
+    measure(t == Warrior ? "spawn_warriors_mass" : "spawn_cars_mass", "ns/op",
+            [&mid, t] {
+      const int n = 10;
+      double time = 0;
+      for (int k = 0; k < n; ++k) {
+        Board b = mid;
+        b.set_random_seed(SEED + k);
+        vector<int> dead;
+        for (int id = 0; id < b.nb_units(); ++id) {
+          Unit u = b.unit(id);
+          if (u.type == t and id%2 == 0) {
+            dead.push_back(id);
+            b.grid_[u.pos.i][u.pos.j].id = -1;
+          }
+        }
+        Clock::time_point t0 = Clock::now();
+        if (t == Warrior) b.spawn_warriors(dead);
+        else b.spawn_cars(dead);
+        time += elapsed(t0);
+      }
+      return time/n;
+    });
+  }
+}
+
+
+void Bench::bench_reset () {
+  const Board& mid = *mid_;
+  measure("player_reset", "ns/op", [&mid] {
+    const int n = 1000;
+    Player* p = Registry::new_player("Null");
+    Clock::time_point t0 = Clock::now();
+    for (int k = 0; k < n; ++k) p->reset(mid);
+    double t = elapsed(t0);
+    delete p;
+    return t/n;
+  });
+}
+
+
+void Bench::bench_print () {
+  const Board& mid = *mid_;
+  ostringstream oss;
+  mid.print_state(oss);
+  double bytes = oss.str().size();
+
+  measure("print_state", "ns/op", [&mid] {
+    const int n = 100;
+    ostringstream oss;
+    Clock::time_point t0 = Clock::now();
+    for (int k = 0; k < n; ++k) {
+      oss.str("");
+      mid.print_state(oss);
+    }
+    return elapsed(t0)/n;
+  });
+
+  measure("print_state_rate", "MB/s", [&mid, bytes] {
+    const int n = 100;
+    ostringstream oss;
+    Clock::time_point t0 = Clock::now();
+    for (int k = 0; k < n; ++k) {
+      oss.str("");
+      mid.print_state(oss);
+    }
+    return 1e3*n*bytes/elapsed(t0);
+  });
+}
+
+
+void Bench::bench_spatial () {
+  // Queries around every cell of the mid-game board.
+  const Board& mid = *mid_;
+  measure("count_in_radius", "ns/op", [&mid] {
+    int count = 0;
+    Clock::time_point t0 = Clock::now();
+    for (int i = 0; i < mid.rows(); ++i)
+      for (int j = 0; j < mid.cols(); ++j)
+        count += mid.count_in_radius(Pos(i, j), 5, j%mid.nb_players(), Warrior);
+    double t = elapsed(t0);
+    _my_assert(count >= 0, "Wrong count.");
+    return t/(mid.rows()*mid.cols());
+  });
+
+  measure("nearest_units", "ns/op", [&mid] {
+    int found = 0;
+    Clock::time_point t0 = Clock::now();
+    for (int i = 0; i < mid.rows(); ++i)
+      for (int j = 0; j < mid.cols(); ++j)
+        found += mid.nearest_units(Pos(i, j), 3, -1, Car).size();
+    double t = elapsed(t0);
+    _my_assert(found > 0, "No units found.");
+    return t/(mid.rows()*mid.cols());
+  });
+
+  measure("legal_moves", "ns/unit", [&mid] {
+    const int n = 100;
+    vector<int> ids, masks;
+    for (int id = 0; id < mid.nb_units(); ++id) ids.push_back(id);
+    Clock::time_point t0 = Clock::now();
+    for (int k = 0; k < n; ++k) mid.legal_moves(ids, masks);
+    return elapsed(t0)/(n*ids.size());
+  });
+}
+
+
+void Bench::queue_bfs (const Board& b, const vector<Pos>& sources,
+                       UnitType ut, int max_dist, Grid<int>& dist) {
+  dist.assign(b.rows(), b.cols(), -1);
+  queue<Pos> Q;
+  for (Pos p : sources) {
+    dist[p] = 0;
+    Q.push(p);
+  }
+  while (not Q.empty()) {
+    Pos p = Q.front();
+    Q.pop();
+    if (dist[p] == max_dist) continue;
+    for (int d = 0; d < 8; ++d) {
+      Pos q = p + Dir(d);
+      if (b.pos_ok(q) and dist[q] == -1 and b.can_stand(q, ut)) {
+        dist[q] = dist[p] + 1;
+        Q.push(q);
+      }
+    }
+  }
+}
+
+
+void Bench::bench_bfs () {
+  // Distances to the stations for cars, and to the cars within 4 steps for
+  // warriors, on the mid-game board.
+  const Board& mid = *mid_;
+  vector<Pos> stations, cars;
+  for (int i = 0; i < mid.rows(); ++i)
+    for (int j = 0; j < mid.cols(); ++j)
+      if (mid.cell(i, j).type == Station) stations.push_back(Pos(i, j));
+  for (int pl = 0; pl < mid.nb_players(); ++pl)
+    for (int id : mid.cars(pl)) cars.push_back(mid.unit(id).pos);
+  Bitboard station_cells = mid.cells_of(Station);
+  Bitboard car_cells = mid.unit_cells(-1, Car);
+  Bitboard car_passable = mid.passable_cells(Car);
+  Bitboard warrior_passable = mid.passable_cells(Warrior);
+  const int n = 100;
+
+  measure("bfs_queue", "ns/op", [&mid, &stations] {
+    Grid<int> dist;
+    Clock::time_point t0 = Clock::now();
+    for (int k = 0; k < n; ++k) queue_bfs(mid, stations, Car, INT_MAX, dist);
+    return elapsed(t0)/n;
+  });
+
+  measure("bfs_bits", "ns/op", [&station_cells, &car_passable] {
+    Grid<int> dist;
+    Clock::time_point t0 = Clock::now();
+    for (int k = 0; k < n; ++k) bfs_distances(car_passable, station_cells, dist);
+    return elapsed(t0)/n;
+  });
+
+  measure("bfs_queue_radius", "ns/op", [&mid, &cars] {
+    Grid<int> dist;
+    Clock::time_point t0 = Clock::now();
+    for (int k = 0; k < n; ++k) queue_bfs(mid, cars, Warrior, 4, dist);
+    return elapsed(t0)/n;
+  });
+
+  measure("bfs_bits_radius", "ns/op", [&car_cells, &warrior_passable] {
+    Grid<int> dist;
+    Clock::time_point t0 = Clock::now();
+    for (int k = 0; k < n; ++k) bfs_distances(warrior_passable, car_cells, dist, 4);
+    return elapsed(t0)/n;
+  });
+}
+
+
+void Bench::bench_paths () {
+  // Searches from every car of the mid-game board, up to 30 moves away,
+  // where a step costs 1 from a Road cell and 4 from any other (as Nil18).
+  const Board& mid = *mid_;
+  vector<Pos> cars;
+  for (int pl = 0; pl < mid.nb_players(); ++pl)
+    for (int id : mid.cars(pl)) cars.push_back(mid.unit(id).pos);
+  auto cost = [&mid] (Pos p, Pos) { return mid.cell_ref(p).type == Road ? 1 : 4; };
+  auto visit = [] (Pos, int) { return false; };
+  const int range = 30;
+
+  measure("car_search_heap", "ns/car", [&mid, &cars, cost, visit] {
+    Path_finder pf(mid);
+    Clock::time_point t0 = Clock::now();
+    for (Pos p : cars) pf.dijkstra(p, Car, cost, visit, range);
+    return elapsed(t0)/cars.size();
+  });
+
+  measure("car_search_dial", "ns/car", [&mid, &cars, cost, visit] {
+    Path_finder pf(mid);
+    Clock::time_point t0 = Clock::now();
+    for (Pos p : cars) pf.dial(p, Car, cost, visit, 4, range);
+    return elapsed(t0)/cars.size();
+  });
+
+  measure("car_search_all", "ns/car", [&mid, &cars, cost, visit] {
+    Path_finder pf(mid);
+    Clock::time_point t0 = Clock::now();
+    pf.dial(cars, Car, cost, visit, 4, range);
+    return elapsed(t0)/cars.size();
+  });
+}
+
+
+void Bench::bench_eval () {
+  // The warrior map of Nil18, from the distance fields to water and cities.
+  const Board& mid = *mid_;
+  int R = mid.rows(), C = mid.cols();
+  Grid<int> water(R, C), city(R, C), in_city(R, C), ok(R, C);
+  for (int i = 0; i < R; ++i)
+    for (int j = 0; j < C; ++j) {
+      Pos p(i, j);
+      int dw = mid.distance_field(Water, Warrior)[i*C + j];
+      int dc = mid.distance_field(City, Warrior)[i*C + j];
+      water[i][j] = (dw == -1 ? 1e9 : dw);
+      city[i][j] = (dc == -1 ? 1e9 : dc);
+      in_city[i][j] = (mid.cell(p).type == City);
+      ok[i][j] = mid.can_stand(p, Warrior);
+    }
+  const int n = 100;
+
+  measure("score_map_cells", "ns/op", [&] {
+    Grid<int> score;
+    Clock::time_point t0 = Clock::now();
+    for (int k = 0; k < n; ++k) {
+      score.assign(R, C, 0);
+      for (int i = 0; i < R; ++i)
+        for (int j = 0; j < C; ++j) {
+          int& w = score[i][j];
+          if (not ok[i][j]) w = -1;
+          else {
+            if (in_city[i][j]) w += 50;
+            if (water[i][j] < 8) w += 20 - water[i][j];
+            if (city[i][j] < 8) w += 20 - city[i][j];
+            if (water[i][j] + city[i][j] < 12) w += 50;
+          }
+        }
+    }
+    return elapsed(t0)/n;
+  });
+
+  measure("score_map", "ns/op", [&] {
+    Grid<int> score;
+    vector<const Grid<int>*> layers = { &in_city, &water, &city, &ok };
+    vector<Score_term> terms = { {0, -1, INT_MAX, 0, 50}, {1, -1, 8, 20, -1},
+                                 {2, -1, 8, 20, -1}, {1, 2, 12, 50, 0} };
+    Clock::time_point t0 = Clock::now();
+    for (int k = 0; k < n; ++k) evaluate(layers, terms, 3, score);
+    return elapsed(t0)/n;
+  });
+}
+
+
+void Bench::bench_simulate () {
+  // A player tries random actions for all its units on the mid-game board.
+  const Board& mid = *mid_;
+  measure("simulate_round", "ns/op", [&mid] {
+    const int n = 50;
+    Random_generator rnd;
+    rnd.set_random_seed(SEED);
+    Simulator sim;
+    vector<Action> act;
+    double t = 0;
+    for (int k = 0; k < n; ++k) {
+      random_actions(mid, 1, rnd, act);
+      Clock::time_point t0 = Clock::now();
+      sim.next(mid, act, SEED + k);
+      t += elapsed(t0);
+    }
+    return t/n;
+  });
+}
+
+
+void Bench::bench_players () {
+  // Four copies of each player play the first rounds of a game.
+  for (string name : Registry::names()) {
+    const Board& start = *start_;
+    measure("play_" + name, "ns/op", [&start, name] {
+      Board b = start;
+      int np = b.nb_players();
+      vector<Player*> players;
+      for (int pl = 0; pl < np; ++pl) {
+        players.push_back(Registry::new_player(name));
+        players[pl]->me_ = pl;
+        players[pl]->set_random_seed(SEED + pl + 1);
+        *static_cast<Settings*>(players[pl]) = (Settings)b;
+      }
+
+      double t = 0;
+      vector<Movement> done;
+      for (int r = 0; r < PLAY_ROUNDS; ++r) {
+        vector<Action> actions(np);
+        for (int pl = 0; pl < np; ++pl) {
+          players[pl]->reset(b);
+          Clock::time_point t0 = Clock::now();
+          players[pl]->play();
+          t += elapsed(t0);
+          actions[pl] = *players[pl];
+        }
+        b.next(actions, done);
+      }
+
+      for (Player* p : players) delete p;
+      return t/(PLAY_ROUNDS*np);
+    });
+  }
+}
+
+
+void Bench::run () {
+  cout << "# name\tunit\tsamples\tmedian\tmean\tstddev\tmin\tmax" << endl;
+  bench_board();
+  bench_next();
+  bench_spawn();
+  bench_reset();
+  bench_print();
+  bench_spatial();
+  bench_bfs();
+  bench_paths();
+  bench_eval();
+  bench_simulate();
+  bench_players();
+}
+
+
+void help (int argc, char** argv) {
+  cout << "Usage: " << argv[0] << " [options]" << endl;
+  cout << "Available options:" << endl;
+  cout << "--samples=n     -n n        number of samples (default: 5)"     << endl;
+  cout << "--filter=text   -f text     only run benchmarks containing text" << endl;
+  cout << "--help          -h          print help"                         << endl;
+}
+
+
+int main (int argc, char** argv) {
+  struct option long_options[] = {
+    { "samples", required_argument, 0, 'n' },
+    { "filter",  required_argument, 0, 'f' },
+    { "help",    no_argument,       0, 'h' },
+    { 0, 0, 0, 0 }
+  };
+
+  int samples = 5;
+  string filter;
+
+  while (true) {
+    int index = 0;
+    int c = getopt_long(argc, argv, "n:f:h", long_options, &index);
+    if (c == -1) break;
+
+    switch (c) {
+      case 'n':
+        samples = string_to_int(optarg);
+        break;
+      case 'f':
+        filter = optarg;
+        break;
+      case 'h':
+        help(argc, argv);
+        return EXIT_SUCCESS;
+      default:
+        help(argc, argv);
+        return EXIT_FAILURE;
+    }
+  }
+  _my_assert(samples > 0, "The number of samples must be positive.");
+
+  // Warnings of random movements and players would only add noise.
+  Log::set_level(LOG_ERROR);
+
+  Bench(samples, filter).run();
+}
@@ -0,0 +1,117 @@
+#include "Bitboard.hh"
+
+
+void Bitboard::set_all () {
+  for (int i = 0; i < rows_; ++i)
+    for (int w = 0; w < words_; ++w) {
+      int n = min(64, cols_ - 64*w);
+      bits_[i*words_ + w] = (n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1);
+    }
+}
+
+
+bool Bitboard::empty () const {
+  for (uint64_t x : bits_)
+    if (x != 0) return false;
+  return true;
+}
+
+
+int Bitboard::count () const {
+  int n = 0;
+  for (uint64_t x : bits_) n += __builtin_popcountll(x);
+  return n;
+}
+
+
+Bitboard& Bitboard::operator|= (const Bitboard& b) {
+  _my_assert(b.rows_ == rows_ and b.cols_ == cols_, "Bitboards of different boards.");
+  for (int k = 0; k < (int)bits_.size(); ++k) bits_[k] |= b.bits_[k];
+  return *this;
+}
+
+
+Bitboard& Bitboard::operator&= (const Bitboard& b) {
+  _my_assert(b.rows_ == rows_ and b.cols_ == cols_, "Bitboards of different boards.");
+  for (int k = 0; k < (int)bits_.size(); ++k) bits_[k] &= b.bits_[k];
+  return *this;
+}
+
+
+/**
+ * Runs the search up to max_dist, calling layer(d, cells) for every
+ * nonempty layer after the sources. Leaves in seen the cells reached.
+ */
+template <class Layer>
+static void expand (const Bitboard& passable, const Bitboard& sources,
+                    int max_dist, Bitboard& seen, Layer layer) {
+  _my_assert(passable.rows() == sources.rows() and passable.cols() == sources.cols(),
+             "Bitboards of different boards.");
+  int R = sources.rows();
+  int W = sources.words();
+  seen = sources;
+  Bitboard frontier = sources;
+  Bitboard next(R, sources.cols());
+
+  // The frontier dilated along its rows, with an empty row above and below.
+  vector<uint64_t> h((R + 2)*W, 0);
+
+  for (int d = 1; d <= max_dist; ++d) {
+    for (int i = 0; i < R; ++i) {
+      const uint64_t* f = frontier.row(i);
+      uint64_t* hr = &h[(i + 1)*W];
+      for (int w = 0; w < W; ++w) {
+        uint64_t left = f[w] << 1;
+        uint64_t right = f[w] >> 1;
+        if (w > 0) left |= f[w - 1] >> 63;
+        if (w + 1 < W) right |= f[w + 1] << 63;
+        hr[w] = f[w] | left | right;
+      }
+    }
+
+    // A cell is in the next layer if the dilated frontier of its row, or of
+    // the rows above or below, covers it.
+    uint64_t any = 0;
+    for (int i = 0; i < R; ++i) {
+      const uint64_t* above = &h[i*W];
+      const uint64_t* p = passable.row(i);
+      uint64_t* s = seen.row(i);
+      uint64_t* n = next.row(i);
+      for (int w = 0; w < W; ++w) {
+        n[w] = (above[w] | above[W + w] | above[2*W + w]) & p[w] & ~s[w];
+        s[w] |= n[w];
+        any |= n[w];
+      }
+    }
+    if (any == 0) return;
+
+    layer(d, next);
+    swap(frontier, next);
+  }
+}
+
+
+void bfs_layers (const Bitboard& passable, const Bitboard& sources,
+                 vector<Bitboard>& layers, int max_dist) {
+  layers.assign(1, sources);
+  Bitboard seen;
+  expand(passable, sources, max_dist, seen,
+         [&layers] (int, const Bitboard& cells) { layers.push_back(cells); });
+}
+
+
+void bfs_distances (const Bitboard& passable, const Bitboard& sources,
+                    Grid<int>& dist, int max_dist) {
+  dist.assign(sources.rows(), sources.cols(), -1);
+  sources.for_each([&dist] (Pos p) { dist[p] = 0; });
+  Bitboard seen;
+  expand(passable, sources, max_dist, seen, [&dist] (int d, const Bitboard& cells) {
+    cells.for_each([&dist, d] (Pos p) { dist[p] = d; });
+  });
+}
+
+
+void bfs_reach (const Bitboard& passable, const Bitboard& sources,
+                int radius, Bitboard& reach) {
+  expand(passable, sources, radius, reach, [] (int, const Bitboard&) { });
+}
@@ -0,0 +1,147 @@
+#ifndef Bitboard_hh
+#define Bitboard_hh
+
+
+#include "Grid.hh"
+
+#include <climits>
+#include <cstdint>
+
+
+/** \file
+ * Contains a set of cells stored as bits, and breadth-first searches that
+ * expand a whole layer of cells with a few word operations.
+ */
+
+
+/**
+ * A set of cells of a board of rows*cols cells. Every row takes words()
+ * 64-bit words, and column j is bit j%64 of word j/64 of its row: the same
+ * layout as the occupancy bitboards of Info.
+ */
+class Bitboard {
+
+  int rows_;
+  int cols_;
+  int words_;
+  vector<uint64_t> bits_;
+
+public:
+
+  /**
+   * Empty board of 0x0 cells.
+   */
+  Bitboard () : rows_(0), cols_(0), words_(0) { }
+
+  /**
+   * Empty set of cells of a board of rows*cols cells.
+   */
+  Bitboard (int rows, int cols)
+    : rows_(rows), cols_(cols), words_((cols + 63)/64), bits_(rows*words_, 0) { }
+
+  inline int rows () const { return rows_; }
+  inline int cols () const { return cols_; }
+
+  /**
+   * Returns the number of words of every row.
+   */
+  inline int words () const { return words_; }
+
+  /**
+   * Returns the words of row i.
+   */
+  inline uint64_t* row (int i) { return &bits_[i*words_]; }
+  inline const uint64_t* row (int i) const { return &bits_[i*words_]; }
+
+  /**
+   * Returns whether p is in the set. p must be inside the board.
+   */
+  inline bool test (Pos p) const {
+    return (bits_[p.i*words_ + p.j/64] >> (p.j%64)) & 1;
+  }
+
+  /**
+   * Adds p to the set. p must be inside the board.
+   */
+  inline void set (Pos p) {
+    bits_[p.i*words_ + p.j/64] |= uint64_t(1) << (p.j%64);
+  }
+
+  /**
+   * Removes p from the set. p must be inside the board.
+   */
+  inline void reset (Pos p) {
+    bits_[p.i*words_ + p.j/64] &= ~(uint64_t(1) << (p.j%64));
+  }
+
+  /**
+   * Removes all the cells.
+   */
+  inline void clear () {
+    fill(bits_.begin(), bits_.end(), 0);
+  }
+
+  /**
+   * Adds all the cells of the board.
+   */
+  void set_all ();
+
+  /**
+   * Returns whether the set is empty.
+   */
+  bool empty () const;
+
+  /**
+   * Returns the number of cells in the set.
+   */
+  int count () const;
+
+  /**
+   * Union and intersection with a set of the same board.
+   */
+  Bitboard& operator|= (const Bitboard& b);
+  Bitboard& operator&= (const Bitboard& b);
+
+  /**
+   * Calls f(p) for every cell p of the set, in row-major order.
+   */
+  template <class F>
+  void for_each (F f) const {
+    for (int i = 0; i < rows_; ++i)
+      for (int w = 0; w < words_; ++w)
+        for (uint64_t x = bits_[i*words_ + w]; x != 0; x &= x - 1)
+          f(Pos(i, 64*w + __builtin_ctzll(x)));
+  }
+
+};
+
+
+/**
+ * Multi-source breadth-first search on the 8-connected board. Layer d holds
+ * the cells of passable at exactly d steps from the closest source, moving
+ * only through passable cells; layer 0 holds the sources, which need not be
+ * passable. Stores the layers up to max_dist, and stops earlier when a layer
+ * is empty (which is not stored).
+ *
+ * Every layer is found by dilating the previous one with shifts and masks,
+ * a few operations per word of the board, instead of visiting its cells.
+ */
+void bfs_layers (const Bitboard& passable, const Bitboard& sources,
+                 vector<Bitboard>& layers, int max_dist = INT_MAX);
+
+/**
+ * Same as bfs_layers, but stores in dist the distance of every cell (0 for
+ * the sources), or -1 for the cells farther than max_dist or unreachable.
+ */
+void bfs_distances (const Bitboard& passable, const Bitboard& sources,
+                    Grid<int>& dist, int max_dist = INT_MAX);
+
+/**
+ * Same as bfs_layers, but stores in reach the union of the layers: the
+ * cells at most radius steps away from some source, sources included.
+ */
+void bfs_reach (const Bitboard& passable, const Bitboard& sources,
+                int radius, Bitboard& reach);
+
+
+#endif
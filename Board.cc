@@ -2,10 +2,57 @@
 #include "Action.hh"
 
 
+/**
+ * The default configuration. Every dimension is a constant, so that loops
+ * have constant bounds.
+ */
+struct Board::Fixed_shape {
+
+  static const int ROWS = 60;
+  static const int COLS = 60;
+  static const int PLAYERS = 4;
+
+  static bool matches (const Settings& s) {
+    return s.rows() == ROWS and s.cols() == COLS and s.nb_players() == PLAYERS;
+  }
+
+  int rows () const { return ROWS; }
+  int cols () const { return COLS; }
+  int players () const { return PLAYERS; }
+
+  bool pos_ok (Pos p) const {
+    return unsigned(p.i) < unsigned(ROWS) and unsigned(p.j) < unsigned(COLS);
+  }
+
+};
+
+
+/**
+ * Any other configuration, with the dimensions read at run time.
+ */
+struct Board::Dynamic_shape {
+
+  int rows_, cols_, players_;
+
+  Dynamic_shape (const Settings& s)
+    : rows_(s.rows()), cols_(s.cols()), players_(s.nb_players()) { }
+
+  int rows () const { return rows_; }
+  int cols () const { return cols_; }
+  int players () const { return players_; }
+
+  bool pos_ok (Pos p) const {
+    return unsigned(p.i) < unsigned(rows_) and unsigned(p.j) < unsigned(cols_);
+  }
+
+};
+
+
 void Board::capture (int id, int pl, vector<bool>& killed) {
   Unit& u = unit_[id];
   assert(u.player != pl);
 
+  delta_.captures.push_back(Capture{id, u.player, pl, u.pos, Pos(-1, -1)});
   u.player = pl;
   if (u.type == Warrior) u.food = u.water = warriors_health();
   else {
@@ -40,7 +87,8 @@ vector<int> Board::two_different (int pl1, int pl2) {
 
 
 // id is a valid unit id, moved by its player, and d is a valid dir != None.
-bool Board::move (int id, Dir dir, vector<bool>& killed) {
+template <class S>
+bool Board::move (const S& s, int id, Dir dir, vector<bool>& killed) {
   Unit& u = unit_[id];
   Pos p1 = u.pos;
   assert(pos_ok(p1));
@@ -50,7 +98,7 @@ bool Board::move (int id, Dir dir, vector<bool>& killed) {
          or (c1.type == City and u.type == Warrior));
 
   Pos p2 = p1 + dir;
-  if (not pos_ok(p2)) return false;
+  if (not s.pos_ok(p2)) return false;
 
   Cell& c2 = grid_[p2.i][p2.j];
   if (c2.type != Desert and c2.type != Road
@@ -123,75 +171,51 @@ bool Board::move (int id, Dir dir, vector<bool>& killed) {
 
 
 void Board::compute_scores () {
-  num_cities_ = vector<int>(nb_players(), 0);
+  if (fixed_shape_) compute_scores(Fixed_shape());
+  else compute_scores(Dynamic_shape(*this));
+}
+
+
+template <class S>
+void Board::compute_scores (const S& s) {
+  num_cities_.assign(s.players(), 0);
   for (int i = 0; i < nb_cities(); ++i) {
-    int owner = cell(cells_cities_[i][0]).owner;
-    vector<int> counter(nb_players(), 0);
-    for (int j = 0; j < (int)cells_cities_[i].size(); ++j) {
-      Pos pos = cells_cities_[i][j];
-      assert(grid_[pos.i][pos.j].owner == owner);
-      int id = grid_[pos.i][pos.j].id;
-      if (id != -1) {
-        Unit u = unit(id);
-        assert(u.type == Warrior);
-        assert(player_ok(u.player));
-        ++counter[u.player];
-      }
-    }
+    const vector<Pos>& cells = cities()[i];
+    int old_owner = grid_[cells[0].i][cells[0].j].owner;
+    int owner = old_owner;
+    const int* counter = &city_warriors_[i*s.players()];
 
     int mx = 0;
-    for (int c : counter) mx = max(mx, c);
+    for (int pl = 0; pl < s.players(); ++pl) mx = max(mx, counter[pl]);
     if (counter[owner] < mx) {
       int q = 0;
-      for (int c : counter)
-        if (c == mx) ++q;
+      for (int pl = 0; pl < s.players(); ++pl)
+        if (counter[pl] == mx) ++q;
       if (q == 1) {
-        for (int pl = 0; pl < nb_players(); ++pl)
+        for (int pl = 0; pl < s.players(); ++pl)
           if (counter[pl] == mx) owner = pl;
-        for (int j = 0; j < (int)cells_cities_[i].size(); ++j) {
-          Pos pos = cells_cities_[i][j];
-          grid_[pos.i][pos.j].owner = owner;
-        }
+        for (const Pos& pos : cells) grid_[pos.i][pos.j].owner = owner;
+        delta_.cities.push_back(City_change{i, old_owner, owner});
       }
     }
     ++num_cities_[owner];
   }
 
-  for (int pl = 0; pl < nb_players(); ++pl) total_score_[pl] += num_cities_[pl];
+  for (int pl = 0; pl < s.players(); ++pl) total_score_[pl] += num_cities_[pl];
 }
 
 
 // ***************************************************************************
 
 
-void Board::dfs (int i, int j, int owner, vector<vector<bool>>& seen,
-                 vector<Pos>& cells) const {
-  assert(i >= 0 and i < rows() and j >= 0 and j < cols());
-  if (seen[i][j]) return;
-  seen[i][j] = true;
-  if (grid_[i][j].type == Desert) return;
-  assert(grid_[i][j].type == City and grid_[i][j].owner == owner);
-  cells.push_back(Pos(i, j));
-  dfs(i + 1, j, owner, seen, cells);
-  dfs(i - 1, j, owner, seen, cells);
-  dfs(i, j + 1, owner, seen, cells);
-  dfs(i, j - 1, owner, seen, cells);
-}
-
-
 void Board::detect_cities () {
-  cells_cities_ = vector<vector<Pos>>(0);
-  vector<vector<bool>> seen(rows(), vector<bool>(cols(), false));
-  for (int i = 0; i < rows(); ++i)
-    for (int j = 0; j < cols(); ++j)
-      if (grid_[i][j].type == City and not seen[i][j]) {
-        int owner = grid_[i][j].owner;
-        assert(player_ok(owner));
-        vector<Pos> cells;
-        dfs(i, j, owner, seen, cells);
-        cells_cities_.push_back(cells);
-      }
-  assert((int)cells_cities_.size() == nb_cities());
+  compute_cities();
+  assert((int)cities().size() == nb_cities());
+  for (const vector<Pos>& cells : cities()) {
+    int owner = grid_[cells[0].i][cells[0].j].owner;
+    assert(player_ok(owner));
+    for (Pos p : cells) assert(grid_[p.i][p.j].owner == owner);
+  }
 }
 
 
@@ -208,13 +232,14 @@ void Board::generate_units () {
   vector<vector<Pos>> cells_per_player(nb_players());
   vector<int> segurs(nb_players(), 0);
   for (int i = 0; i < nb_cities(); ++i) {
-    assert(not cells_cities_[i].empty());
-    int pl = cell(cells_cities_[i][0]).owner;
+    const vector<Pos>& cells = cities()[i];
+    assert(not cells.empty());
+    int pl = cell(cells[0]).owner;
     assert(player_ok(pl));
     ++segurs[pl];
-    int ran = random(0, cells_cities_[i].size() - 1);
-    for (int j = 0; j < (int)cells_cities_[i].size(); ++j) {
-      Pos pos = cells_cities_[i][j];
+    int ran = random(0, cells.size() - 1);
+    for (int j = 0; j < (int)cells.size(); ++j) {
+      Pos pos = cells[j];
       if (j == ran) new_unit(id, pl, pos, Warrior);
       else cells_per_player[pl].push_back(pos);
     }
@@ -253,20 +278,176 @@ void Board::generate_units () {
 // ***************************************************************************
 
 
-Board::Board (istream& is, int seed) {
+Board::Board (istream& is, int seed)
+  : Board(Settings::read_settings(is), is, seed) { }
+
+
+Board::Board (const Settings& settings, istream& is, int seed) {
+  reset(settings, is, seed);
+}
+
+
+void Board::reset (const Settings& settings, istream& is, int seed) {
   set_random_seed(seed);
-  *static_cast<Settings*>(this) = Settings::read_settings(is);
-  names_ = vector<string>(nb_players());
+  *static_cast<Settings*>(this) = settings;
+  fixed_shape_ = Fixed_shape::matches(*this);
+  names_.assign(nb_players(), string());
   read_generator_and_grid(is);
   round_ = 0;
-  num_cities_ = vector<int>(nb_players(), 0);
-  total_score_ = vector<int>(nb_players(), 0);
-  cpu_status_ = vector<double>(nb_players(), 0);
-  unit_ = vector<Unit>(nb_players()*(nb_warriors() + nb_cars()));
+  num_cities_.assign(nb_players(), 0);
+  total_score_.assign(nb_players(), 0);
+  cpu_status_.assign(nb_players(), 0);
+  unit_.assign(nb_players()*(nb_warriors() + nb_cars()), Unit());
+  delta_.movements.clear();
+  delta_.captures.clear();
+  delta_.cities.clear();
   detect_cities();
   generate_units();
   update_vectors_by_player();
   compute_scores();
+  compute_distances();
+  compute_landmarks();
+  compute_passable();
+}
+
+
+/**
+ * Helpers to write and read the binary checkpoints.
+ */
+template <typename T>
+static void put (ostream& os, T x) {
+  os.write((const char*)&x, sizeof(T));
+}
+
+template <typename T>
+static T get (istream& is) {
+  T x;
+  is.read((char*)&x, sizeof(T));
+  _my_assert(is, "Truncated checkpoint.");
+  return x;
+}
+
+static void put_string (ostream& os, const string& s) {
+  put<int>(os, s.size());
+  os.write(s.data(), s.size());
+}
+
+static string get_string (istream& is) {
+  string s(get<int>(is), ' ');
+  is.read(&s[0], s.size());
+  _my_assert(is, "Truncated checkpoint.");
+  return s;
+}
+
+
+Board::Board (const Info& info) {
+  assign(info);
+}
+
+
+void Board::assign (const Info& info) {
+  *static_cast<Info*>(this) = info;
+  fixed_shape_ = Fixed_shape::matches(*this);
+  names_.resize(nb_players());
+}
+
+
+void Board::save (ostream& os) const {
+  put_string(os, version());
+  for (int x : { nb_players_, nb_rounds_, nb_cities_, nb_warriors_, nb_cars_,
+                 warriors_health_, cars_fuel_, damage_, rows_, cols_ })
+    put<int>(os, x);
+  put<long long>(os, rnd_seed);
+  put_string(os, generator_);
+  for (const string& name : names_) put_string(os, name);
+
+  // Unit ids in the grid are not saved, they are given by the units.
+  for (int i = 0; i < rows(); ++i)
+    for (int j = 0; j < cols(); ++j) {
+      put<signed char>(os, grid_[i][j].type);
+      put<signed char>(os, grid_[i][j].owner);
+    }
+  for (const vector<Pos>& city : cities()) {
+    put<int>(os, city.size());
+    for (Pos p : city) {
+      put<short>(os, p.i);
+      put<short>(os, p.j);
+    }
+  }
+
+  put<int>(os, round_);
+  for (const Unit& u : unit_) {
+    put<signed char>(os, u.type);
+    put<signed char>(os, u.player);
+    put<int>(os, u.food);
+    put<int>(os, u.water);
+    put<short>(os, u.pos.i);
+    put<short>(os, u.pos.j);
+  }
+  for (int pl = 0; pl < nb_players(); ++pl) {
+    put<int>(os, num_cities_[pl]);
+    put<int>(os, total_score_[pl]);
+    put<double>(os, cpu_status_[pl]);
+  }
+}
+
+
+Board::Board (istream& is) {
+  _my_assert(get_string(is) == version(), "Checkpoint of another game version.");
+  for (int* x : { &nb_players_, &nb_rounds_, &nb_cities_, &nb_warriors_, &nb_cars_,
+                  &warriors_health_, &cars_fuel_, &damage_, &rows_, &cols_ })
+    *x = get<int>(is);
+  fixed_shape_ = Fixed_shape::matches(*this);
+  rnd_seed = get<long long>(is);
+  generator_ = get_string(is);
+  names_ = vector<string>(nb_players());
+  for (string& name : names_) name = get_string(is);
+
+  grid_.assign(rows(), cols());
+  for (int i = 0; i < rows(); ++i)
+    for (int j = 0; j < cols(); ++j) {
+      grid_[i][j].type = CellType(get<signed char>(is));
+      grid_[i][j].owner = get<signed char>(is);
+      _my_assert(grid_[i][j].type >= Desert and grid_[i][j].type < CellTypeSize,
+                 "Wrong cell in checkpoint.");
+    }
+  vector< vector<Pos> > cities(nb_cities());
+  for (vector<Pos>& city : cities) {
+    city = vector<Pos>(get<int>(is));
+    for (Pos& p : city) {
+      p.i = get<short>(is);
+      p.j = get<short>(is);
+      _my_assert(pos_ok(p), "Wrong city in checkpoint.");
+    }
+  }
+  set_cities(cities);
+
+  round_ = get<int>(is);
+  unit_ = vector<Unit>(nb_players()*(nb_warriors() + nb_cars()));
+  for (int id = 0; id < nb_units(); ++id) {
+    Unit& u = unit_[id];
+    u.id = id;
+    u.type = UnitType(get<signed char>(is));
+    u.player = get<signed char>(is);
+    u.food = get<int>(is);
+    u.water = get<int>(is);
+    u.pos.i = get<short>(is);
+    u.pos.j = get<short>(is);
+    _my_assert(ut_ok(u.type) and player_ok(u.player) and pos_ok(u.pos),
+               "Wrong unit in checkpoint.");
+    grid_[u.pos.i][u.pos.j].id = id;
+  }
+  num_cities_ = total_score_ = vector<int>(nb_players());
+  cpu_status_ = vector<double>(nb_players());
+  for (int pl = 0; pl < nb_players(); ++pl) {
+    num_cities_[pl] = get<int>(is);
+    total_score_[pl] = get<int>(is);
+    cpu_status_[pl] = get<double>(is);
+  }
+  update_vectors_by_player();
+  compute_distances();
+  compute_landmarks();
+  compute_passable();
 }
 
 
@@ -292,44 +473,9 @@ void Board::print_names (ostream& os) const {
 }
 
 
-void Board::print_state (ostream& os) const {
-  os << endl << endl;
-
-  for (int i = 0; i < rows(); ++i) {
-    for (int j = 0; j < cols(); ++j) {
-      const Cell& c = grid_[i][j];
-      if (c.type == Wall) os << 'X';
-      else if (c.type == Road) os << 'R';
-      else if (c.type == Station) os << 'S';
-      else if (c.type == Water) os << 'W';
-      else if (c.owner == -1) os << '.';
-      else if (player_ok(c.owner)) os << c.owner;
-      else assert(false);
-    }
-    os << endl;
-  }
-
-  os << endl;
-  os << "round " << round() << endl;
-
-  os << "num_cities";
-  for (auto nc : num_cities_) os << " " << nc;
-  os << endl;
-
-  os << "total_score";
-  for (auto ts : total_score_) os << " " << ts;
-  os << endl;
-
-  os << "status";
-  for (auto st : cpu_status_) os << " " << st;
-  os << endl;
-
-  for (int id = 0; id < nb_units(); ++id) print_unit(unit(id), os);
-  os << endl;
-}
-
-
 void Board::print_results () const {
+  // The results are always printed, after any pending log messages.
+  Log::flush();
   int max_score = 0;
   vector<int> v;
   for (int pl = 0; pl < nb_players(); ++pl) {
@@ -367,51 +513,49 @@ bool Board::adjacent (int id, CellType t) const {
 }
 
 
-bool Board::pos_safe (Pos p) const {
-  for (int x = -4; x <= 4; ++x)
-    for (int y = -4; y <= 4; ++y) {
-      Pos q = p + Pos(x, y);
-      if (pos_ok(q) and grid_[q.i][q.j].id != -1) return false;
-    }
+template <class S>
+bool Board::pos_safe (const S& s, Pos p) const {
+  int i0 = max(p.i - 4, 0), i1 = min(p.i + 4, s.rows() - 1);
+  int j0 = max(p.j - 4, 0), j1 = min(p.j + 4, s.cols() - 1);
+  for (int i = i0; i <= i1; ++i) {
+    const Cell* row = grid_[i];
+    for (int j = j0; j <= j1; ++j)
+      if (row[j].id != -1) return false;
+  }
   return true;
 }
 
 
-void Board::spawn_cars (const vector<int>& dead_c) {
-  vector<vector<int>> dist(rows(), vector<int>(cols(), -1));
-  queue<Pos> Q;
-  for (int i = 0; i < rows(); ++i)
-    for (int j = 0; j < cols(); ++j) {
-      int id = grid_[i][j].id;
-      if (id != -1) {
-        dist[i][j] = 0;
-        Q.push(Pos(i, j));
-      }
-    }
+template <class S>
+void Board::spawn (const S& s, const vector<int>& dead, CellType t) {
+  int morts = dead.size();
+  if (morts == 0) return;
 
-  while (not Q.empty()) {
-    Pos q = Q.front(); Q.pop();
-    for (int d = 0; d < 8; ++d) {
-      Pos p = q + Dir(d);
-      if (pos_ok(p) and dist[p.i][p.j] == -1) {
-        dist[p.i][p.j] = dist[q.i][q.j] + 1;
-        Q.push(p);
-      }
-    }
-  }
+  int R = s.rows();
+  int C = s.cols();
 
-  int morts = dead_c.size();
+  // Cells at less than 4 steps from a unit.
+  Bitboard units(R, C), all(R, C), near;
+  for (int id = 0; id < (int)unit_.size(); ++id) {
+    Pos p = unit_[id].pos;
+    if (s.pos_ok(p) and grid_[p.i][p.j].id == id) units.set(p);
+  }
+  all.set_all();
+  bfs_reach(all, units, 3, near);
 
+  // Cars can also appear at the last cell of every side, warriors cannot.
+  int last = (t == Road ? 0 : 1);
   vector<Pos> pos;
-  for (int i = 1; i < rows(); ++i) {
-    if (grid_[i][0].type == Road and dist[i][0] >= 4) pos.push_back(Pos(i, 0));
-    if (grid_[i][cols()-1].type == Road and dist[i][cols()-1] >= 4) pos.push_back(Pos(i, cols()-1));
+  for (int i = 1; i < R - last; ++i) {
+    if (grid_[i][0].type == t and not near.test(Pos(i, 0))) pos.push_back(Pos(i, 0));
+    if (grid_[i][C-1].type == t and not near.test(Pos(i, C-1))) pos.push_back(Pos(i, C-1));
   }
-  for (int j = 1; j < cols(); ++j) {
-    if (grid_[0][j].type == Road and dist[0][j] >= 4) pos.push_back(Pos(0, j));
-    if (grid_[rows()-1][j].type == Road and dist[rows()-1][j] >= 4) pos.push_back(Pos(rows()-1, j));
+  for (int j = 1; j < C - last; ++j) {
+    if (grid_[0][j].type == t and not near.test(Pos(0, j))) pos.push_back(Pos(0, j));
+    if (grid_[R-1][j].type == t and not near.test(Pos(R-1, j))) pos.push_back(Pos(R-1, j));
   }
 
+  int M = min(R, C)/2;
   vector<int> perm = random_permutation(morts);
   for (int k = 0; k < morts; ++k) {
     Pos p(-1, -1);
@@ -420,147 +564,88 @@ void Board::spawn_cars (const vector<int>& dead_c) {
       p = pos[z];
       pos[z] = pos.back();
       pos.pop_back();
-      if (not pos_safe(p)) p = Pos(-1, -1);
+      if (not pos_safe(s, p)) p = Pos(-1, -1);
     }
 
     bool found = (p != Pos(-1, -1));
-    for (int m = 1; not found and m < 30; ++m) {
-      for (int i = m; not found and i < 60 - m; ++i) {
+    for (int m = 1; not found and m < M; ++m) {
+      for (int i = m; not found and i < R - m; ++i) {
         p = Pos(i, m);
-        if (grid_[p.i][p.j].type == Road and pos_safe(p)) found = true;
+        if (grid_[p.i][p.j].type == t and pos_safe(s, p)) found = true;
       }
-      for (int i = m; not found and i < 60 - m; ++i) {
-        p = Pos(i, 60 - m - 1);
-        if (grid_[p.i][p.j].type == Road and pos_safe(p)) found = true;
+      for (int i = m; not found and i < R - m; ++i) {
+        p = Pos(i, C - m - 1);
+        if (grid_[p.i][p.j].type == t and pos_safe(s, p)) found = true;
       }
-      for (int j = m; not found and j < 60 - m; ++j) {
+      for (int j = m; not found and j < C - m; ++j) {
         p = Pos(m, j);
-        if (grid_[p.i][p.j].type == Road and pos_safe(p)) found = true;
+        if (grid_[p.i][p.j].type == t and pos_safe(s, p)) found = true;
       }
-      for (int j = m; not found and j < 60 - m; ++j) {
-        p = Pos(60 - m - 1, j);
-        if (grid_[p.i][p.j].type == Road and pos_safe(p)) found = true;
+      for (int j = m; not found and j < C - m; ++j) {
+        p = Pos(R - m - 1, j);
+        if (grid_[p.i][p.j].type == t and pos_safe(s, p)) found = true;
       }
     }
 
-    for (int m = 0; not found and m < 30; ++m) {
-      for (int i = m; not found and i < 60 - m; ++i) {
+    for (int m = 0; not found and m < M; ++m) {
+      for (int i = m; not found and i < R - m; ++i) {
         p = Pos(i, m);
-        if (grid_[p.i][p.j].type == Road and grid_[p.i][p.j].id == -1) found = true;
+        if (grid_[p.i][p.j].type == t and grid_[p.i][p.j].id == -1) found = true;
       }
-      for (int i = m; not found and i < 60 - m; ++i) {
-        p = Pos(i, 60 - m - 1);
-        if (grid_[p.i][p.j].type == Road and grid_[p.i][p.j].id == -1) found = true;
+      for (int i = m; not found and i < R - m; ++i) {
+        p = Pos(i, C - m - 1);
+        if (grid_[p.i][p.j].type == t and grid_[p.i][p.j].id == -1) found = true;
       }
-      for (int j = m; not found and j < 60 - m; ++j) {
+      for (int j = m; not found and j < C - m; ++j) {
         p = Pos(m, j);
-        if (grid_[p.i][p.j].type == Road and grid_[p.i][p.j].id == -1) found = true;
+        if (grid_[p.i][p.j].type == t and grid_[p.i][p.j].id == -1) found = true;
       }
-      for (int j = m; not found and j < 60 - m; ++j) {
-        p = Pos(60 - m - 1, j);
-        if (grid_[p.i][p.j].type == Road and grid_[p.i][p.j].id == -1) found = true;
+      for (int j = m; not found and j < C - m; ++j) {
+        p = Pos(R - m - 1, j);
+        if (grid_[p.i][p.j].type == t and grid_[p.i][p.j].id == -1) found = true;
       }
     }
 
     assert(found);
-    place(dead_c[perm[k]], p);
+    place(dead[perm[k]], p);
   }
 }
 
 
-void Board::spawn_warriors (const vector<int>& dead_w) {
-  vector<vector<int>> dist(rows(), vector<int>(cols(), -1));
-  queue<Pos> Q;
-  for (int i = 0; i < rows(); ++i)
-    for (int j = 0; j < cols(); ++j) {
-      int id = grid_[i][j].id;
-      if (id != -1) {
-        dist[i][j] = 0;
-        Q.push(Pos(i, j));
-      }
-    }
+void Board::spawn_cars (const vector<int>& dead_c) {
+  if (fixed_shape_) spawn(Fixed_shape(), dead_c, Road);
+  else spawn(Dynamic_shape(*this), dead_c, Road);
+}
 
-  while (not Q.empty()) {
-    Pos q = Q.front(); Q.pop();
-    for (int d = 0; d < 8; ++d) {
-      Pos p = q + Dir(d);
-      if (pos_ok(p) and dist[p.i][p.j] == -1) {
-        dist[p.i][p.j] = dist[q.i][q.j] + 1;
-        Q.push(p);
-      }
-    }
-  }
 
-  int morts = dead_w.size();
+void Board::spawn_warriors (const vector<int>& dead_w) {
+  if (fixed_shape_) spawn(Fixed_shape(), dead_w, Desert);
+  else spawn(Dynamic_shape(*this), dead_w, Desert);
+}
+
 
-  vector<Pos> pos;
-  for (int i = 1; i < rows() - 1; ++i) {
-    if (grid_[i][0].type == Desert and dist[i][0] >= 4) pos.push_back(Pos(i, 0));
-    if (grid_[i][cols()-1].type == Desert and dist[i][cols()-1] >= 4) pos.push_back(Pos(i, cols()-1));
-  }
-  for (int j = 1; j < cols() - 1; ++j) {
-    if (grid_[0][j].type == Desert and dist[0][j] >= 4) pos.push_back(Pos(0, j));
-    if (grid_[rows()-1][j].type == Desert and dist[rows()-1][j] >= 4) pos.push_back(Pos(rows()-1, j));
-  }
+void Board::print_movements (const vector<Movement>& done, ostream& os) {
+  os << "movements" << endl;
+  Action::print_actions(done, os);
+}
 
-  vector<int> perm = random_permutation(morts);
-  for (int k = 0; k < morts; ++k) {
-    Pos p(-1, -1);
-    while (p == Pos(-1, -1) and not pos.empty()) {
-      int z = random(0, pos.size() - 1);
-      p = pos[z];
-      pos[z] = pos.back();
-      pos.pop_back();
-      if (not pos_safe(p)) p = Pos(-1, -1);
-    }
 
-    bool found = (p != Pos(-1, -1));
-    for (int m = 1; not found and m < 30; ++m) {
-      for (int i = m; not found and i < 60 - m; ++i) {
-        p = Pos(i, m);
-        if (grid_[p.i][p.j].type == Desert and pos_safe(p)) found = true;
-      }
-      for (int i = m; not found and i < 60 - m; ++i) {
-        p = Pos(i, 60 - m - 1);
-        if (grid_[p.i][p.j].type == Desert and pos_safe(p)) found = true;
-      }
-      for (int j = m; not found and j < 60 - m; ++j) {
-        p = Pos(m, j);
-        if (grid_[p.i][p.j].type == Desert and pos_safe(p)) found = true;
-      }
-      for (int j = m; not found and j < 60 - m; ++j) {
-        p = Pos(60 - m - 1, j);
-        if (grid_[p.i][p.j].type == Desert and pos_safe(p)) found = true;
-      }
-    }
+void Board::next (const vector<Action>& act, ostream& os) {
+  vector<Movement> done;
+  next(act, done);
+  print_movements(done, os);
+}
 
-    for (int m = 0; not found and m < 30; ++m) {
-      for (int i = m; not found and i < 60 - m; ++i) {
-        p = Pos(i, m);
-        if (grid_[p.i][p.j].type == Desert and grid_[p.i][p.j].id == -1) found = true;
-      }
-      for (int i = m; not found and i < 60 - m; ++i) {
-        p = Pos(i, 60 - m - 1);
-        if (grid_[p.i][p.j].type == Desert and grid_[p.i][p.j].id == -1) found = true;
-      }
-      for (int j = m; not found and j < 60 - m; ++j) {
-        p = Pos(m, j);
-        if (grid_[p.i][p.j].type == Desert and grid_[p.i][p.j].id == -1) found = true;
-      }
-      for (int j = m; not found and j < 60 - m; ++j) {
-        p = Pos(60 - m - 1, j);
-        if (grid_[p.i][p.j].type == Desert and grid_[p.i][p.j].id == -1) found = true;
-      }
-    }
 
-    assert(found);
-    place(dead_w[perm[k]], p);
-  }
+void Board::next (const vector<Action>& act, vector<Movement>& done) {
+  if (fixed_shape_) next(Fixed_shape(), act, done);
+  else next(Dynamic_shape(*this), act, done);
 }
 
 
-void Board::next (const vector<Action>& act, ostream& os) {
-  int np = nb_players();
+template <class S>
+void Board::next (const S& s, const vector<Action>& act, vector<Movement>& done) {
+  int np = s.players();
   int nu = nb_units();
 
   // chooses (at most) one movement per unit
@@ -570,21 +655,26 @@ void Board::next (const vector<Action>& act, ostream& os) {
     for (const Movement& m : act[pl].v_) {
       int id = m.id;
       Dir dir = m.dir;
-      if (not unit_ok(id)) cerr << "warning: id out of range :" << id << endl;
+      if (not unit_ok(id)) {
+        _log_warning(LogBoard, "id out of range :" << id);
+      }
       else {
         Unit u = unit(id);
-        if (u.player != pl)
-          cerr << "warning: not own unit: " << id << ' ' << u.player
-               << ' ' << pl << endl;
+        if (u.player != pl) {
+          _log_warning(LogBoard, "not own unit: " << id << ' ' << u.player
+                       << ' ' << pl);
+        }
         else {
           _my_assert(not seen[id], "More than one command for the same unit.");
           seen[id] = true;
-          if (not dir_ok(dir))
-            cerr << "warning: direction not valid: " << dir << endl;
+          if (not dir_ok(dir)) {
+            _log_warning(LogBoard, "direction not valid: " << dir);
+          }
           else if (dir != None) {
-            if (not can_move(id))
-              cerr << "warning: cannot move: " << id << ' ' << pl
-                   << ' ' << round() << endl;
+            if (not can_move(id)) {
+              _log_warning(LogBoard, "cannot move: " << id << ' ' << pl
+                           << ' ' << round());
+            }
             else v.push_back(Movement(id, dir));
           }
         }
@@ -595,14 +685,15 @@ void Board::next (const vector<Action>& act, ostream& os) {
   // makes all movements using a random order
   vector<int> perm = random_permutation(num);
   vector<bool> killed(nu, false);
-  vector<Movement> actions_done;
+  done.clear();
+  delta_.captures.clear();
+  delta_.cities.clear();
   for (int i = 0; i < num; ++i) {
     Movement m = v[perm[i]];
-    if (not killed[m.id] and move(m.id, m.dir, killed))
-      actions_done.push_back(m);
+    if (not killed[m.id] and move(s, m.id, m.dir, killed))
+      done.push_back(m);
   }
-  os << "movements" << endl;
-  Action::print_actions(actions_done, os);
+  delta_.movements = done;
 
   // reduces health from units that could move (and perhaps kills them)
   for (int id = 0; id < nu; ++id)
@@ -629,13 +720,14 @@ void Board::next (const vector<Action>& act, ostream& os) {
       (t == Warrior ? dead_w : dead_c).push_back(id);
     }
 
-  spawn_cars(dead_c);
+  spawn(s, dead_c, Road);
 
-  spawn_warriors(dead_w);
+  spawn(s, dead_w, Desert);
+  for (Capture& c : delta_.captures) c.new_pos = unit_[c.id].pos;
 
   update_vectors_by_player();
 
-  compute_scores();
+  compute_scores(s);
 
   // recharges food
   for (int id = 0; id < nu; ++id)
@@ -874,7 +966,7 @@ inline bool Board::possible_station (int i, int j) const {
 
 
 int Board::basic_distribution () {
-  grid_ = vector< vector<Cell> >(60, vector<Cell>(60, char2cell('.')));
+  grid_.assign(60, 60, char2cell('.'));
 
   int n = random(5, 7);
   int m = random(5, 7);
@@ -945,7 +1037,7 @@ int Board::basic_distribution () {
     --q;
   }
 
-  seen_ = vector<vector<bool>>(60, vector<bool>(60, false));
+  seen_.fill(false);
   zone_.clear();
   for (int i = 1; i < n; ++i)
     for (int j = 1; j < m; ++j)
@@ -20,17 +20,17 @@ class Board : public Info, public Random_generator {
 
   friend class Game;
   friend class SecGame;
+  friend class Bench;
 
   vector<string> names_;
   string generator_;
-  vector< vector<Pos> > cells_cities_;
 
   /**
    * Used by generate random maps.
    */
   map<Pos, Pos> parent_;
   map<Pos, int> area_;
-  vector<vector<bool>> seen_;
+  Grid<char, 60, 60> seen_;
   vector<vector<Pos>> zone_;
   vector<int> X_, Y_;
 
@@ -40,22 +40,38 @@ class Board : public Info, public Random_generator {
 
   vector<int> two_different (int pl1, int pl2);
 
+  /**
+   * Shapes of the board for the functions compiled once per shape.
+   * Fixed_shape is the default configuration (60x60, 4 players), with all
+   * its dimensions known at compile time; Dynamic_shape fits any board.
+   */
+  struct Fixed_shape;
+  struct Dynamic_shape;
+
+  /**
+   * Whether the board has the default configuration, and so uses the
+   * functions compiled for Fixed_shape.
+   */
+  bool fixed_shape_;
+
   /**
    * Tries to apply a move. Returns true if it could. Marks killed units.
    */
-  bool move (int id, Dir dir, vector<bool>& killed);
+  template <class S>
+  bool move (const S& s, int id, Dir dir, vector<bool>& killed);
 
   /**
    * Computes the current number of cities owned,
    * and updates the total scores of all players.
    */
   void compute_scores ();
+  template <class S> void compute_scores (const S& s);
 
   /**
-   * To mark every city at the start of the game.
+   * Body of next() for a given shape.
    */
-  void dfs (int i, int j, int owner, vector<vector<bool>>& seen,
-            vector<Pos>& cells) const;
+  template <class S>
+  void next (const S& s, const vector<Action>& act, vector<Movement>& done);
 
   /**
    * Detects and stores all the cities of the board at the start of the game.
@@ -82,18 +98,6 @@ class Board : public Info, public Random_generator {
    */
   void generator (vector<int> param);
 
-  /**
-   * Prints some information of the unit.
-   */
-  inline static void print_unit (Unit u, ostream& os) {
-    os << ut2char(u.type) << ' '
-       << u.player << ' '
-       << u.pos.i << ' '
-       << u.pos.j << ' '
-       << u.food << ' '
-       << u.water << endl;
-  }
-
   /**
    * Used to spawn_units.
    */
@@ -107,7 +111,14 @@ class Board : public Info, public Random_generator {
   /**
    * Used to spawn units.
    */
-  inline bool pos_safe (Pos p) const;
+  template <class S> bool pos_safe (const S& s, Pos p) const;
+
+  /**
+   * Spawns the dead units in cells of type t (Road for cars, Desert for
+   * warriors), as far as possible from the other units.
+   */
+  template <class S>
+  void spawn (const S& s, const vector<int>& dead, CellType t);
 
   /**
    * Used by generate random maps.
@@ -142,6 +153,41 @@ public:
    */
   Board (istream& is, int seed);
 
+  /**
+   * Construct a board with the given settings, reading the generator
+   * (and the grid, if it is fixed) from a stream.
+   */
+  Board (const Settings& settings, istream& is, int seed);
+
+  /**
+   * Starts a new game on the board, as the constructor with the same
+   * arguments, but reusing the memory of the board.
+   */
+  void reset (const Settings& settings, istream& is, int seed);
+
+  /**
+   * Construct a board from a checkpoint written by save().
+   */
+  explicit Board (istream& is);
+
+  /**
+   * Construct a board with the settings and state of info, to play rounds
+   * from it (see Simulator).
+   */
+  explicit Board (const Info& info);
+
+  /**
+   * Replaces the settings and state of the board with those of info,
+   * reusing the memory of the board.
+   */
+  void assign (const Info& info);
+
+  /**
+   * Writes a binary checkpoint of the board, from which the game can be
+   * resumed exactly (including the state of the random generator).
+   */
+  void save (ostream& os) const;
+
   /**
    * Prints the board preamble to a stream.
    */
@@ -152,11 +198,6 @@ public:
    */
   void print_names (ostream& os) const;
 
-  /**
-   * Prints the state of the board to a stream.
-   */
-  void print_state (ostream& os) const;
-
   /**
    * Prints the results and the names of the winning players.
    */
@@ -172,9 +213,19 @@ public:
    */
   void spawn_warriors (const vector<int>& dead_w);
 
+  /**
+   * Prints the movements performed in a round to a stream.
+   */
+  static void print_movements (const vector<Movement>& done, ostream& os);
+
   /**
    * Computes the next board aplying the given actions to the current board.
-   * It also prints to os the actual actions performed.
+   * It also stores in done the actual actions performed.
+   */
+  void next (const vector<Action>& act, vector<Movement>& done);
+
+  /**
+   * Same as above, but printing the actual actions performed to os.
    */
   void next (const vector<Action>& act, ostream& os);
 
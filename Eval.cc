@@ -0,0 +1,141 @@
+#include "Eval.hh"
+
+#if defined(__x86_64__) or defined(__i386__)
+#include <immintrin.h>
+#define EVAL_X86
+#endif
+
+
+/**
+ * Kernels for a term, and for the mask, on the n cells of the arrays.
+ * The values are computed as unsigned, to wrap around as the vectors do.
+ */
+typedef void (*Term_kernel) (const int* a, const int* b, const Score_term& t,
+                             int* score, int n);
+typedef void (*Mask_kernel) (const int* mask, int* score, int n);
+
+struct Kernels {
+  Term_kernel term;
+  Mask_kernel mask;
+};
+
+
+static void term_scalar (const int* a, const int* b, const Score_term& t,
+                         int* score, int n) {
+  for (int k = 0; k < n; ++k) {
+    unsigned v = unsigned(a[k]) + (b ? unsigned(b[k]) : 0);
+    if (int(v) < t.below)
+      score[k] = int(unsigned(score[k]) + unsigned(t.base) + unsigned(t.slope)*v);
+  }
+}
+
+
+static void mask_scalar (const int* mask, int* score, int n) {
+  for (int k = 0; k < n; ++k)
+    if (mask[k] == 0) score[k] = -1;
+}
+
+
+#ifdef EVAL_X86
+
+__attribute__((target("avx2")))
+static void term_avx2 (const int* a, const int* b, const Score_term& t,
+                       int* score, int n) {
+  __m256i below = _mm256_set1_epi32(t.below);
+  __m256i base = _mm256_set1_epi32(t.base);
+  __m256i slope = _mm256_set1_epi32(t.slope);
+  int k = 0;
+  for (; k + 8 <= n; k += 8) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(a + k));
+    if (b) v = _mm256_add_epi32(v, _mm256_loadu_si256((const __m256i*)(b + k)));
+    __m256i x = _mm256_add_epi32(base, _mm256_mullo_epi32(slope, v));
+    x = _mm256_and_si256(x, _mm256_cmpgt_epi32(below, v));
+    __m256i s = _mm256_loadu_si256((const __m256i*)(score + k));
+    _mm256_storeu_si256((__m256i*)(score + k), _mm256_add_epi32(s, x));
+  }
+  term_scalar(a + k, b ? b + k : 0, t, score + k, n - k);
+}
+
+
+__attribute__((target("avx2")))
+static void mask_avx2 (const int* mask, int* score, int n) {
+  // Or-ing -1 into the score gives -1.
+  __m256i zero = _mm256_setzero_si256();
+  int k = 0;
+  for (; k + 8 <= n; k += 8) {
+    __m256i m = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(mask + k)), zero);
+    __m256i s = _mm256_loadu_si256((const __m256i*)(score + k));
+    _mm256_storeu_si256((__m256i*)(score + k), _mm256_or_si256(s, m));
+  }
+  mask_scalar(mask + k, score + k, n - k);
+}
+
+
+__attribute__((target("sse4.1")))
+static void term_sse (const int* a, const int* b, const Score_term& t,
+                      int* score, int n) {
+  __m128i below = _mm_set1_epi32(t.below);
+  __m128i base = _mm_set1_epi32(t.base);
+  __m128i slope = _mm_set1_epi32(t.slope);
+  int k = 0;
+  for (; k + 4 <= n; k += 4) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(a + k));
+    if (b) v = _mm_add_epi32(v, _mm_loadu_si128((const __m128i*)(b + k)));
+    __m128i x = _mm_add_epi32(base, _mm_mullo_epi32(slope, v));
+    x = _mm_and_si128(x, _mm_cmplt_epi32(v, below));
+    __m128i s = _mm_loadu_si128((const __m128i*)(score + k));
+    _mm_storeu_si128((__m128i*)(score + k), _mm_add_epi32(s, x));
+  }
+  term_scalar(a + k, b ? b + k : 0, t, score + k, n - k);
+}
+
+
+__attribute__((target("sse4.1")))
+static void mask_sse (const int* mask, int* score, int n) {
+  __m128i zero = _mm_setzero_si128();
+  int k = 0;
+  for (; k + 4 <= n; k += 4) {
+    __m128i m = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(mask + k)), zero);
+    __m128i s = _mm_loadu_si128((const __m128i*)(score + k));
+    _mm_storeu_si128((__m128i*)(score + k), _mm_or_si128(s, m));
+  }
+  mask_scalar(mask + k, score + k, n - k);
+}
+
+#endif
+
+
+/**
+ * Chooses the kernels for this processor.
+ */
+static Kernels choose_kernels () {
+#ifdef EVAL_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) return Kernels{term_avx2, mask_avx2};
+  if (__builtin_cpu_supports("sse4.1")) return Kernels{term_sse, mask_sse};
+#endif
+  return Kernels{term_scalar, mask_scalar};
+}
+
+
+void evaluate (const vector<const Grid<int>*>& layers,
+               const vector<Score_term>& terms, int mask, Grid<int>& score) {
+  static const Kernels kernels = choose_kernels();
+
+  _my_assert(not layers.empty(), "No layers to evaluate.");
+  int rows = layers[0]->rows();
+  int cols = layers[0]->cols();
+  for (const Grid<int>* l : layers)
+    _my_assert(l->rows() == rows and l->cols() == cols, "Layers of different boards.");
+  _my_assert(mask >= -1 and mask < (int)layers.size(), "Wrong mask layer.");
+
+  score.assign(rows, cols, 0);
+  int n = rows*cols;
+  for (const Score_term& t : terms) {
+    _my_assert(t.a >= 0 and t.a < (int)layers.size()
+               and t.b >= -1 and t.b < (int)layers.size(), "Wrong term layer.");
+    const int* b = (t.b == -1 ? 0 : layers[t.b]->data());
+    kernels.term(layers[t.a]->data(), b, t, score.data(), n);
+  }
+  if (mask != -1) kernels.mask(layers[mask]->data(), score.data(), n);
+}
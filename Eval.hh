@@ -0,0 +1,44 @@
+#ifndef Eval_hh
+#define Eval_hh
+
+
+#include "Grid.hh"
+
+
+/** \file
+ * Contains a kernel to compute score maps from layers of features of the
+ * cells, such as distance fields.
+ */
+
+
+/**
+ * A term of a score map. Its value at a cell is v, the value of layer a
+ * there plus the value of layer b (if b is not -1): where v < below, the
+ * term adds base + slope*v to the score of the cell.
+ */
+struct Score_term {
+
+  int a;
+  int b;
+  int below;
+  int base;
+  int slope;
+
+};
+
+
+/**
+ * Stores in score the sum of the terms at every cell, or -1 at the cells
+ * where the layer mask is 0 (if mask is not -1). Terms and mask refer to
+ * layers by their index in layers, which must all have the same extents.
+ * score takes them too.
+ *
+ * The cells are processed 8 (with AVX2) or 4 (with SSE4.1) at a time, as
+ * supported by the processor, one term after the other; the result is the
+ * same as adding the terms cell by cell, with 32-bit wrap-around.
+ */
+void evaluate (const vector<const Grid<int>*>& layers,
+               const vector<Score_term>& terms, int mask, Grid<int>& score);
+
+
+#endif
@@ -1,29 +1,97 @@
 #include "Game.hh"
+#include "Watchdog.hh"
 
+#include <cerrno>
+#include <csignal>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
-void Game::run (vector<string> names, istream& is, ostream& os, int seed) {
-  cerr << "info: seed " << seed << endl;
 
-  cerr << "info: loading game" << endl;
-  Board b(is, seed);
-  cerr << "info: loaded game" << endl;
+/**
+ * Magic number at the start of the checkpoints written by Game.
+ */
+static const int CHECKPOINT_MAGIC = 0x4b43414d; // "MACK"
 
+
+void Game::play (Board& b, const vector<Player*>& players, Output_stage* out,
+                 int seed, const Game_options& opt) {
   int np = b.nb_players();
   int nr = b.nb_rounds();
 
+  Watchdog* wd = 0;
+  if (opt.cpu_time > 0 or opt.round_time > 0)
+    wd = new Watchdog(np, opt.cpu_time, opt.round_time);
+
+  vector<Movement> done;
+  for (int round = b.round(); round < nr; ++round) {
+    if (round == opt.save_round and not opt.save_file.empty()) {
+      _log_info(LogGame, "saving checkpoint " << opt.save_file);
+      ofstream f(opt.save_file.c_str(), ios::binary);
+      f.write((const char*)&CHECKPOINT_MAGIC, sizeof(int));
+      f.write((const char*)&seed, sizeof(int));
+      b.save(f);
+      for (int pl = 0; pl < np; ++pl)
+        f.write((const char*)&players[pl]->rnd_seed, sizeof(long long));
+      _my_assert(f, "Cannot write checkpoint " + opt.save_file + ".");
+    }
+
+    _log_debug(LogGame, "start round " << round);
+    vector<Action> actions(np);
+    for (int pl = 0; pl < np; ++pl) {
+      _log_debug(LogGame, "    start player " << pl);
+      if (b.cpu_status_[pl] < 0) continue; // dead players do nothing
+      players[pl]->reset(b);
+      if (wd) b.cpu_status_[pl] = wd->play(players[pl], pl);
+      else players[pl]->play();
+      if (b.cpu_status_[pl] >= 0) actions[pl] = *players[pl];
+      _log_debug(LogGame, "    end player " << pl);
+    }
+
+    b.next(actions, done);
+    if (out) out->push(done, b);
+    _log_debug(LogGame, "end round " << round);
+  }
+
+  delete wd;
+}
+
+
+void Game::run (vector<string> names, istream& is, ostream& os, int seed,
+                const Game_options& opt) {
+  ifstream ckpt;
+  if (not opt.resume_file.empty()) {
+    ckpt.open(opt.resume_file.c_str(), ios::binary);
+    int magic = 0;
+    ckpt.read((char*)&magic, sizeof(int));
+    ckpt.read((char*)&seed, sizeof(int));
+    _my_assert(ckpt and magic == CHECKPOINT_MAGIC,
+               "Cannot read checkpoint " + opt.resume_file + ".");
+  }
+
+  _log_info(LogGame, "seed " << seed);
+
+  _log_info(LogGame, "loading game");
+  Board b = ckpt.is_open() ? Board(ckpt) : Board(is, seed);
+  _log_info(LogGame, "loaded game");
+
+  int np = b.nb_players();
+
   _my_assert(np == (int)names.size(), "Wrong number of players.");
 
   vector<Player*> players;
   for (int pl = 0; pl < np; ++pl) {
     string name = names[pl];
     b.names_[pl] = name;
-    cerr << "info: loading player " << name << endl;
+    _log_info(LogGame, "loading player " << name);
     players.push_back(Registry::new_player(name));
     players[pl]->me_ = pl;
     players[pl]->set_random_seed(seed + pl + 1);
+    if (ckpt.is_open()) ckpt.read((char*)&players[pl]->rnd_seed, sizeof(long long));
     *static_cast<Settings*>(players[pl]) = (Settings)b;
   }
-  cerr << "info: players loaded" << endl;
+  _my_assert(not ckpt.is_open() or ckpt, "Truncated checkpoint.");
+  _log_info(LogGame, "players loaded");
 
   os << "Game" << endl << endl;
   os << "Seed " << seed << endl << endl;
@@ -31,23 +99,128 @@ void Game::run (vector<string> names, istream& is, ostream& os, int seed) {
   b.print_names(os);
   b.print_state(os);
 
-  for (int round = 0; round < nr; ++round) {
-    cerr << "info: start round " << round << endl;
-    vector<Action> actions(np);
-    for (int pl = 0; pl < np; ++pl) {
-      cerr << "info:     start player " << pl << endl;
-      players[pl]->reset(b);
-      players[pl]->play();
-      actions[pl] = *players[pl];
-      cerr << "info:     end player " << pl << endl;
+  // The trace of every round is written while the next one is played.
+  Output_stage out(os);
+  play(b, players, &out, seed, opt);
+  out.flush();
+  b.print_results();
+
+  _log_info(LogGame, "game played");
+}
+
+
+string Game::batch_game (Board& b, const vector<string>& names,
+                         const vector<Registry::Factory>& factory,
+                         int seed, const Game_options& opt) {
+  int np = b.nb_players();
+  vector<Player*> players(np);
+  for (int pl = 0; pl < np; ++pl) {
+    b.names_[pl] = names[pl];
+    players[pl] = factory[pl]();
+    players[pl]->me_ = pl;
+    players[pl]->set_random_seed(seed + pl + 1);
+    *static_cast<Settings*>(players[pl]) = (Settings)b;
+  }
+
+  play(b, players, 0, seed, opt);
+
+  int top = 0;
+  for (int pl = 0; pl < np; ++pl) top = max(top, b.total_score(pl));
+  ostringstream line;
+  line << seed;
+  for (int pl = 0; pl < np; ++pl) line << '\t' << b.total_score(pl);
+  line << '\t';
+  string sep;
+  for (int pl = 0; pl < np; ++pl)
+    if (b.total_score(pl) == top) {
+      line << sep << names[pl];
+      sep = ",";
     }
+  line << endl;
+
+  // A dead player may still be running in a thread of the Watchdog.
+  for (int pl = 0; pl < np; ++pl)
+    if (b.cpu_status_[pl] >= 0) delete players[pl];
+  return line.str();
+}
+
+
+string Game::forked_batch_game (Board& b, const vector<string>& names,
+                                const vector<Registry::Factory>& factory,
+                                int seed, const Game_options& opt) {
+  int fd[2];
+  _my_assert(pipe(fd) == 0, "Cannot create pipe.");
+
+  // Nothing buffered may be written twice by the child.
+  cout.flush();
+  Log::flush();
 
-    b.next(actions, os);
-    b.print_state(os);
-    cerr << "info: end round " << round << endl;
+  pid_t pid = fork();
+  _my_assert(pid != -1, "Cannot fork game.");
+  if (pid == 0) {
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    close(fd[0]);
+    string line = batch_game(b, names, factory, seed, opt);
+    Log::flush();
+    for (size_t k = 0; k < line.size(); ) {
+      ssize_t n = write(fd[1], line.data() + k, line.size() - k);
+      if (n > 0) k += n;
+      else if (errno != EINTR) _exit(EXIT_FAILURE);
+    }
+    _exit(EXIT_SUCCESS); // Also ends the threads left by the Watchdog.
   }
 
-  b.print_results();
+  close(fd[1]);
+  string line;
+  char buf[256];
+  while (true) {
+    ssize_t n = read(fd[0], buf, sizeof(buf));
+    if (n > 0) line.append(buf, n);
+    else if (n == 0 or errno != EINTR) break;
+  }
+  close(fd[0]);
+
+  int status = 0;
+  while (waitpid(pid, &status, 0) == -1 and errno == EINTR) { }
+  _my_assert(WIFEXITED(status) and WEXITSTATUS(status) == EXIT_SUCCESS
+             and not line.empty(), "Game with seed " << seed << " failed.");
+  return line;
+}
+
+
+void Game::run_batch (vector<string> names, istream& is, ostream& os,
+                      int seed, int games, const Game_options& opt) {
+  _my_assert(opt.save_file.empty() and opt.resume_file.empty(),
+             "Batch mode does not support checkpoints.");
 
-  cerr << "info: game played" << endl;
+  // The settings are parsed once, and the rest of the configuration
+  // (the generator, or a fixed grid) is kept to be read again per game.
+  Settings settings = Settings::read_settings(is);
+  ostringstream rest;
+  rest << is.rdbuf();
+  string grid = rest.str();
+
+  int np = settings.nb_players();
+  _my_assert(np == (int)names.size(), "Wrong number of players.");
+  vector<Registry::Factory> factory;
+  for (const string& name : names) factory.push_back(Registry::factory(name));
+
+  os << "# seed";
+  for (const string& name : names) os << '\t' << name;
+  os << "\ttop" << endl;
+
+  // A single board is reset for every game, keeping its memory.
+  bool timed = opt.cpu_time > 0 or opt.round_time > 0;
+  istringstream gis(grid);
+  Board b(settings, gis, seed);
+  for (int game = 0; game < games; ++game, ++seed) {
+    _log_debug(LogGame, "start game " << game << " with seed " << seed);
+    if (game > 0) {
+      gis.clear();
+      gis.str(grid);
+      b.reset(settings, gis, seed);
+    }
+    if (timed) os << forked_batch_game(b, names, factory, seed, opt);
+    else os << batch_game(b, names, factory, seed, opt);
+  }
 }
@@ -4,6 +4,27 @@
 
 #include "Player.hh"
 #include "Board.hh"
+#include "Output.hh"
+#include "Registry.hh"
+
+
+/**
+ * Optional settings of a game.
+ */
+struct Game_options {
+
+  double cpu_time;     // Total cpu time of each player, in seconds.
+  double round_time;   // Wall time of each round of a player, in seconds.
+  string save_file;    // Where to save a checkpoint, if not empty.
+  int save_round;      // Round at which the checkpoint is saved.
+  string resume_file;  // Checkpoint to resume the game from, if not empty.
+
+  /**
+   * Default options: no time limits and no checkpoints.
+   */
+  Game_options () : cpu_time(0), round_time(0), save_round(0) { }
+
+};
 
 
 /**
@@ -11,9 +32,52 @@
  */
 class Game {
 
+  /**
+   * Plays the rounds of a game from the current one. Writes every round
+   * to out, if given.
+   */
+  static void play (Board& b, const vector<Player*>& players, Output_stage* out,
+                    int seed, const Game_options& opt);
+
+  /**
+   * Plays a game of a batch on b, with new players, and returns its line
+   * of results.
+   */
+  static string batch_game (Board& b, const vector<string>& names,
+                            const vector<Registry::Factory>& factory,
+                            int seed, const Game_options& opt);
+
+  /**
+   * Same as batch_game, but plays the game in a child process, so that
+   * the threads of the players that exceed their time limit end with it.
+   */
+  static string forked_batch_game (Board& b, const vector<string>& names,
+                                   const vector<Registry::Factory>& factory,
+                                   int seed, const Game_options& opt);
+
 public:
 
-  static void run (vector<string> names, istream& is, ostream& os, int seed);
+  /**
+   * Plays a game. If cpu_time or round_time are positive, the players run
+   * under a Watchdog with these limits.
+   *
+   * If resume_file is given, the board is read from that checkpoint
+   * instead of is, and the game goes on from its round. If save_file is
+   * given, a checkpoint is saved there at the start of round save_round.
+   */
+  static void run (vector<string> names, istream& is, ostream& os, int seed,
+                   const Game_options& opt = Game_options());
+
+  /**
+   * Plays a number of games, with seeds seed, seed + 1, ... The settings
+   * are read only once. Instead of the traces, writes to os one line per
+   * game, with its seed, the score of every player and the winner(s),
+   * separated by tabs. Checkpoints are not supported. With time limits,
+   * every game is played in a child process (see forked_batch_game).
+   */
+  static void run_batch (vector<string> names, istream& is, ostream& os,
+                         int seed, int games,
+                         const Game_options& opt = Game_options());
 
 };
 
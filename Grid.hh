@@ -0,0 +1,193 @@
+#ifndef Grid_hh
+#define Grid_hh
+
+
+#include "Structs.hh"
+
+#include <array>
+#include <type_traits>
+
+
+/** \file
+ * Contains a class template to store some data for every cell of a board.
+ */
+
+
+/**
+ * Operations shared by every Grid, on top of the rows(), cols() and data()
+ * of the class G that derives from it.
+ */
+template <class G, class T>
+class Grid_base {
+
+  inline const G& self () const { return *static_cast<const G*>(this); }
+  inline G& self () { return *static_cast<G*>(this); }
+
+public:
+
+  /**
+   * Returns the number of cells.
+   */
+  inline int size () const {
+    return self().rows()*self().cols();
+  }
+
+  /**
+   * Returns whether p is inside the grid.
+   */
+  inline bool pos_ok (Pos p) const {
+    return unsigned(p.i) < unsigned(self().rows())
+       and unsigned(p.j) < unsigned(self().cols());
+  }
+
+  /**
+   * Returns the index of p in data(): the cells are stored row by row.
+   */
+  inline int index (Pos p) const {
+    return p.i*self().cols() + p.j;
+  }
+
+  /**
+   * Returns the position of the cell with index k in data().
+   */
+  inline Pos pos (int k) const {
+    return Pos(k/self().cols(), k%self().cols());
+  }
+
+  /**
+   * Returns row i, so that g[i][j] is the cell at (i, j).
+   */
+  inline T* operator[] (int i) {
+    return self().data() + i*self().cols();
+  }
+
+  inline const T* operator[] (int i) const {
+    return self().data() + i*self().cols();
+  }
+
+  /**
+   * Returns the cell at p.
+   */
+  inline T& operator[] (Pos p) {
+    return self().data()[index(p)];
+  }
+
+  inline const T& operator[] (Pos p) const {
+    return self().data()[index(p)];
+  }
+
+  /**
+   * Sets every cell to value, in one pass over the contiguous storage.
+   */
+  inline void fill (const T& value) {
+    std::fill(self().data(), self().data() + size(), value);
+  }
+
+  /**
+   * Copies size() cells, row by row, from src.
+   */
+  inline void copy_from (const T* src) {
+    std::copy(src, src + size(), self().data());
+  }
+
+  /**
+   * Calls f(q) for every neighbour q of p inside the grid, in the order of
+   * the directions (Bottom, BR, ..., LB).
+   */
+  template <class F>
+  inline void for_each_neighbour (Pos p, F f) const {
+    static const int DI[8] = { 1, 1, 0, -1, -1, -1,  0,  1 };
+    static const int DJ[8] = { 0, 1, 1,  1,  0, -1, -1, -1 };
+    for (int d = 0; d < 8; ++d) {
+      Pos q(p.i + DI[d], p.j + DJ[d]);
+      if (pos_ok(q)) f(q);
+    }
+  }
+
+};
+
+
+/**
+ * A value of type T for every cell of a board of R rows and C columns,
+ * stored contiguously row by row and indexed as g[i][j] or g[p].
+ *
+ * When R and C are given, the grid is an array with its extents known at
+ * compile time, so that loops over it have constant bounds and it can live
+ * on the stack. Grid<T> (R = C = 0) reads its extents at run time.
+ */
+template <class T, int R = 0, int C = 0>
+class Grid : public Grid_base<Grid<T, R, C>, T> {
+
+  static_assert(R > 0 and C > 0, "Both extents must be given.");
+
+  array<T, R*C> cells_;
+
+public:
+
+  /**
+   * Grid with uninitialized cells, if T has no default constructor.
+   */
+  Grid () { }
+
+  /**
+   * Grid with every cell set to value.
+   */
+  explicit Grid (const T& value) {
+    this->fill(value);
+  }
+
+  static constexpr int rows () { return R; }
+  static constexpr int cols () { return C; }
+
+  inline T* data () { return cells_.data(); }
+  inline const T* data () const { return cells_.data(); }
+
+};
+
+
+/**
+ * A grid with its extents read at run time.
+ */
+template <class T>
+class Grid<T, 0, 0> : public Grid_base<Grid<T, 0, 0>, T> {
+
+  static_assert(not is_same<T, bool>::value,
+                "vector<bool> is not contiguous, use Grid<char>.");
+
+  int rows_;
+  int cols_;
+  vector<T> cells_;
+
+public:
+
+  /**
+   * Empty grid.
+   */
+  Grid () : rows_(0), cols_(0) { }
+
+  /**
+   * Grid of rows*cols cells set to value.
+   */
+  Grid (int rows, int cols, const T& value = T())
+    : rows_(rows), cols_(cols), cells_(rows*cols, value) { }
+
+  /**
+   * Changes the extents, and sets every cell to value. Keeps the memory
+   * when the grid does not grow.
+   */
+  inline void assign (int rows, int cols, const T& value = T()) {
+    rows_ = rows;
+    cols_ = cols;
+    cells_.assign(rows*cols, value);
+  }
+
+  inline int rows () const { return rows_; }
+  inline int cols () const { return cols_; }
+
+  inline T* data () { return cells_.data(); }
+  inline const T* data () const { return cells_.data(); }
+
+};
+
+
+#endif
@@ -1 +1,364 @@
 #include "Info.hh"
+
+
+void Info::print_state (ostream& os) const {
+  os << endl << endl;
+
+  for (int i = 0; i < rows(); ++i) {
+    for (int j = 0; j < cols(); ++j) {
+      const Cell& c = grid_[i][j];
+      if (c.type == Wall) os << 'X';
+      else if (c.type == Road) os << 'R';
+      else if (c.type == Station) os << 'S';
+      else if (c.type == Water) os << 'W';
+      else if (c.owner == -1) os << '.';
+      else if (player_ok(c.owner)) os << c.owner;
+      else assert(false);
+    }
+    os << endl;
+  }
+
+  os << endl;
+  os << "round " << round() << endl;
+
+  os << "num_cities";
+  for (auto nc : num_cities_) os << " " << nc;
+  os << endl;
+
+  os << "total_score";
+  for (auto ts : total_score_) os << " " << ts;
+  os << endl;
+
+  os << "status";
+  for (auto st : cpu_status_) os << " " << st;
+  os << endl;
+
+  for (int id = 0; id < nb_units(); ++id) print_unit(unit(id), os);
+  os << endl;
+}
+
+
+/**
+ * Returns whether a unit of type ut can move into a cell of type t.
+ */
+static bool passable (UnitType ut, CellType t) {
+  return t == Desert or t == Road or (t == City and ut == Warrior);
+}
+
+
+/**
+ * Breadth-first search for units of type ut, from the cells in
+ * queue[0..tail), which must have distance 0. The other cells must have
+ * distance -1, and keep it if they cannot be reached.
+ */
+static void bfs (const Info& info, UnitType ut, vector<int>& dist,
+                 vector<int>& queue, int tail) {
+  int cols = info.cols();
+  int head = 0;
+  while (head < tail) {
+    int k = queue[head++];
+    Pos p(k/cols, k%cols);
+    for (int d = 0; d < 8; ++d) {
+      Pos q = p + Dir(d);
+      if (not info.pos_ok(q)) continue;
+      int kq = q.i*cols + q.j;
+      if (dist[kq] == -1 and passable(ut, info.cell_ref(q).type)) {
+        dist[kq] = dist[k] + 1;
+        queue[tail++] = kq;
+      }
+    }
+  }
+}
+
+
+void Info::compute_distances () const {
+  // One multi-source BFS per field, with every cell in the queue at most once.
+  int n = rows()*cols();
+  auto fields = make_shared< vector< vector<int> > >(CellTypeSize*UnitTypeSize,
+                                                     vector<int>(n, -1));
+  vector<int> queue(n);
+  for (int t = 0; t < CellTypeSize; ++t)
+    for (int ut = 0; ut < UnitTypeSize; ++ut) {
+      vector<int>& dist = (*fields)[t*UnitTypeSize + ut];
+      int tail = 0;
+      for (int k = 0; k < n; ++k)
+        if (grid_[k/cols()][k%cols()].type == t) {
+          dist[k] = 0;
+          queue[tail++] = k;
+        }
+      bfs(*this, UnitType(ut), dist, queue, tail);
+    }
+  distances_ = fields;
+}
+
+
+void Info::compute_landmarks () const {
+  // Landmarks are chosen far from each other (farthest-point selection),
+  // so that for most pairs of cells some landmark lies behind one of them.
+  int n = rows()*cols();
+  auto tables = make_shared< vector< vector<int> > >(UnitTypeSize*LANDMARKS,
+                                                     vector<int>(n, -1));
+  vector<int> queue(n);
+  for (int ut = 0; ut < UnitTypeSize; ++ut) {
+    // Returns the passable cell with the greatest d (-1 counts as infinite).
+    auto farthest = [&] (const vector<int>& d) {
+      int best = -1;
+      for (int k = 0; k < n; ++k) {
+        if (not passable(UnitType(ut), grid_[k/cols()][k%cols()].type)) continue;
+        if (best == -1 or (d[best] != -1 and (d[k] == -1 or d[k] > d[best])))
+          best = k;
+      }
+      return best;
+    };
+
+    // The first landmark is the farthest cell from an arbitrary one.
+    vector<int> closest(n, 0);
+    int next = farthest(closest);
+    if (next == -1) continue;
+    closest = vector<int>(n, -1);
+    closest[next] = 0;
+    queue[0] = next;
+    bfs(*this, UnitType(ut), closest, queue, 1);
+    next = farthest(closest);
+
+    for (int l = 0; l < LANDMARKS; ++l) {
+      vector<int>& dist = (*tables)[ut*LANDMARKS + l];
+      dist[next] = 0;
+      queue[0] = next;
+      bfs(*this, UnitType(ut), dist, queue, 1);
+      for (int k = 0; k < n; ++k)
+        if (l == 0 or (dist[k] != -1 and (closest[k] == -1 or dist[k] < closest[k])))
+          closest[k] = dist[k];
+      next = farthest(closest);
+    }
+  }
+  landmarks_ = tables;
+}
+
+
+int Info::distance_bound (Pos a, Pos b, UnitType ut) const {
+  if (not pos_ok(a) or not pos_ok(b) or not ut_ok(ut)) {
+    _log_warning(LogState, "distance bound requested for " << a << ' ' << b);
+    return -1;
+  }
+  if (not landmarks_) compute_landmarks();
+  int ka = a.i*cols() + a.j;
+  int kb = b.i*cols() + b.j;
+  int bound = max(abs(a.i - b.i), abs(a.j - b.j));
+  for (int l = 0; l < LANDMARKS; ++l) {
+    const vector<int>& dist = (*landmarks_)[ut*LANDMARKS + l];
+    int da = dist[ka];
+    int db = dist[kb];
+    if ((da == -1) != (db == -1)) return -1; // different components
+    if (da != -1) bound = max(bound, abs(da - db));
+  }
+  return bound;
+}
+
+
+void Info::compute_passable () const {
+  int w = cols() + 2;
+  auto grids = make_shared< vector< vector<char> > >(UnitTypeSize,
+                                                     vector<char>((rows() + 2)*w, 0));
+  for (int ut = 0; ut < UnitTypeSize; ++ut)
+    for (int i = 0; i < rows(); ++i)
+      for (int j = 0; j < cols(); ++j)
+        (*grids)[ut][(i + 1)*w + j + 1] = passable(UnitType(ut), grid_[i][j].type);
+  passable_ = grids;
+}
+
+
+Bitboard Info::cells_of (CellType t) const {
+  Bitboard b(rows(), cols());
+  for (int i = 0; i < rows(); ++i)
+    for (int j = 0; j < cols(); ++j)
+      if (grid_[i][j].type == t) b.set(Pos(i, j));
+  return b;
+}
+
+
+Bitboard Info::passable_cells (UnitType ut) const {
+  Bitboard b(rows(), cols());
+  if (not ut_ok(ut)) {
+    _log_warning(LogState, "passable cells requested for unit type " << ut);
+    return b;
+  }
+  for (int i = 0; i < rows(); ++i)
+    for (int j = 0; j < cols(); ++j)
+      if (passable(ut, grid_[i][j].type)) b.set(Pos(i, j));
+  return b;
+}
+
+
+Bitboard Info::unit_cells (int pl, UnitType ut) const {
+  Bitboard b(rows(), cols());
+  if ((pl != -1 and not player_ok(pl)) or not ut_ok(ut)) {
+    _log_warning(LogState, "unit cells requested for " << pl << ' ' << ut);
+    return b;
+  }
+  for (int i = 0; i < rows(); ++i)
+    for (int w = 0; w < row_words(); ++w)
+      b.row(i)[w] = occupancy(pl, ut, i, w);
+  return b;
+}
+
+
+int Info::legal_moves (int id) const {
+  vector<int> masks;
+  legal_moves(vector<int>(1, id), masks);
+  return masks[0];
+}
+
+
+void Info::legal_moves (const vector<int>& ids, vector<int>& masks) const {
+  if (not passable_) compute_passable();
+
+  // Offsets of the neighbours in the passability grids, by direction.
+  int w = cols() + 2;
+  int offset[8];
+  for (int d = 0; d < 8; ++d) {
+    Pos q = Pos(0, 0) + Dir(d);
+    offset[d] = q.i*w + q.j;
+  }
+
+  masks.resize(ids.size());
+  for (int k = 0; k < (int)ids.size(); ++k) {
+    int id = ids[k];
+    if (not unit_ok(id)) {
+      _log_warning(LogState, "legal moves requested for identifier " << id);
+      masks[k] = 0;
+      continue;
+    }
+    const Unit& u = unit_[id];
+    int mask = 1 << None;
+    if (can_move(id)) {
+      const char* c = &(*passable_)[u.type][(u.pos.i + 1)*w + u.pos.j + 1];
+      for (int d = 0; d < 8; ++d) mask |= c[offset[d]] << d;
+    }
+    masks[k] = mask;
+  }
+}
+
+
+/**
+ * Adds to cells the City cell at (i, j) and all its neighbours in the city.
+ */
+static void dfs (const Info& info, int i, int j, Grid<char>& seen,
+                 vector<Pos>& cells) {
+  if (not info.pos_ok(i, j) or seen[i][j]) return;
+  seen[i][j] = true;
+  if (info.cell_ref(i, j).type != City) return;
+  cells.push_back(Pos(i, j));
+  dfs(info, i + 1, j, seen, cells);
+  dfs(info, i - 1, j, seen, cells);
+  dfs(info, i, j + 1, seen, cells);
+  dfs(info, i, j - 1, seen, cells);
+}
+
+
+void Info::compute_cities () const {
+  vector< vector<Pos> > cities;
+  Grid<char> seen(rows(), cols(), false);
+  for (int i = 0; i < rows(); ++i)
+    for (int j = 0; j < cols(); ++j)
+      if (grid_[i][j].type == City and not seen[i][j]) {
+        cities.push_back(vector<Pos>());
+        dfs(*this, i, j, seen, cities.back());
+      }
+  set_cities(cities);
+}
+
+
+void Info::set_cities (const vector< vector<Pos> >& cities) const {
+  auto index = make_shared< vector<int> >(rows()*cols(), -1);
+  for (int c = 0; c < (int)cities.size(); ++c)
+    for (Pos p : cities[c]) (*index)[p.i*cols() + p.j] = c;
+  cities_ = make_shared< vector< vector<Pos> > >(cities);
+  city_index_ = index;
+}
+
+
+void Info::index_units () {
+  int np = num_cities_.size();
+  int words = row_words();
+  occupancy_.assign(np*UnitTypeSize*rows()*words, 0);
+  int bcols = (cols() + BUCKET - 1)/BUCKET;
+  int nb = ((rows() + BUCKET - 1)/BUCKET)*bcols;
+  bucket_start_.assign(nb + 1, 0);
+  bucket_units_.resize(unit_.size());
+  const vector<int>& city = city_index();
+  city_warriors_.assign(cities().size()*np, 0);
+
+  // Counting sort of the units by bucket, which keeps them sorted by id.
+  for (const Unit& u : unit_) {
+    int j = u.pos.j;
+    occupancy_[((u.player*UnitTypeSize + u.type)*rows() + u.pos.i)*words + j/64]
+      |= uint64_t(1) << (j%64);
+    ++bucket_start_[(u.pos.i/BUCKET)*bcols + j/BUCKET + 1];
+    int c = city[u.pos.i*cols() + j];
+    if (c != -1 and u.type == Warrior) ++city_warriors_[c*np + u.player];
+  }
+  for (int b = 0; b < nb; ++b) bucket_start_[b + 1] += bucket_start_[b];
+  vector<int> next(bucket_start_.begin(), bucket_start_.end() - 1);
+  for (const Unit& u : unit_)
+    bucket_units_[next[(u.pos.i/BUCKET)*bcols + u.pos.j/BUCKET]++] = u.id;
+
+  // The tables of all players and types are interleaved, and padded to
+  // blocks of LANES, so that a single pass turns the units of every cell
+  // into prefix sums with a vectorised inner loop.
+  _my_assert(unit_.size() <= 0xffff, "Too many units for the prefix counts.");
+  int nt = prefix_stride();
+  int width = (cols() + 1)*nt;
+  auto sums = make_shared< vector<uint16_t> >((rows() + 1)*width, 0);
+  uint16_t* s = sums->data();
+  for (const Unit& u : unit_)
+    s[(u.pos.i + 1)*width + (u.pos.j + 1)*nt + u.player*UnitTypeSize + u.type] = 1;
+  for (int i = 1; i <= rows(); ++i)
+    for (int b = 0; b < nt; b += LANES) {
+      uint16_t acc[LANES] = { };
+      for (int j = 1; j <= cols(); ++j) {
+        uint16_t* c = s + i*width + j*nt + b;
+        const uint16_t* up = c - width;
+        // Loads everything before storing, as c and up could overlap.
+        uint16_t v[LANES];
+        for (int t = 0; t < LANES; ++t) v[t] = up[t] + (acc[t] += c[t]);
+        for (int t = 0; t < LANES; ++t) c[t] = v[t];
+      }
+    }
+  prefix_counts_ = sums;
+}
+
+
+vector<int> Info::nearest_units (Pos p, int k, int pl, UnitType ut) const {
+  vector<int> res;
+  if (not pos_ok(p) or k <= 0) return res;
+
+  // Buckets are visited in square rings around the bucket of p. Every unit
+  // in ring d (d > 0) is at distance at least (d - 1)*BUCKET + 1 from p.
+  int brows = (rows() + BUCKET - 1)/BUCKET;
+  int bcols = (cols() + BUCKET - 1)/BUCKET;
+  int bi = p.i/BUCKET;
+  int bj = p.j/BUCKET;
+  int last = max(max(bi, brows - 1 - bi), max(bj, bcols - 1 - bj));
+  vector< pair<int, int> > found; // (distance, id)
+  for (int d = 0; d <= last; ++d) {
+    if ((int)found.size() >= k) {
+      nth_element(found.begin(), found.begin() + k - 1, found.end());
+      if (found[k - 1].first < (d - 1)*BUCKET + 1) break;
+    }
+    for (int x = max(0, bi - d); x <= min(brows - 1, bi + d); ++x)
+      for (int y = max(0, bj - d); y <= min(bcols - 1, bj + d); ++y) {
+        if (max(abs(x - bi), abs(y - bj)) != d) continue;
+        int b = x*bcols + y;
+        for (int e = bucket_start_[b]; e < bucket_start_[b + 1]; ++e) {
+          const Unit& u = unit_[bucket_units_[e]];
+          if (u.type == ut and (pl == -1 or u.player == pl))
+            found.push_back({max(abs(u.pos.i - p.i), abs(u.pos.j - p.j)), u.id});
+        }
+      }
+  }
+
+  sort(found.begin(), found.end());
+  for (int e = 0; e < k and e < (int)found.size(); ++e) res.push_back(found[e].second);
+  return res;
+}
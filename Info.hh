@@ -4,6 +4,9 @@
 
 #include "Settings.hh"
 #include "State.hh"
+#include "Bitboard.hh"
+
+#include <memory>
 
 
 /*! \file
@@ -19,9 +22,119 @@ class Info : public Settings, public State {
 
   friend class Game;
   friend class SecGame;
+  friend class Player;
+
+  /**
+   * Distance fields, indexed by CellType*UnitTypeSize + UnitType, each
+   * with one distance per cell (row by row). Cell types never change during
+   * a game, so they are computed once and shared by all copies of the board.
+   */
+  mutable shared_ptr<const vector< vector<int> > > distances_;
+
+  /**
+   * Distance tables of the landmarks, indexed by UnitType*LANDMARKS +
+   * landmark, with the number of moves from the landmark to every cell
+   * (-1 if it cannot be reached). Shared as distances_.
+   */
+  mutable shared_ptr<const vector< vector<int> > > landmarks_;
+
+  /**
+   * For every type of unit, whether it can stand on every cell, in a grid
+   * with a border of cells where it cannot: the cell at (i, j) has index
+   * (i + 1)*(cols() + 2) + j + 1. Shared as distances_.
+   */
+  mutable shared_ptr<const vector< vector<char> > > passable_;
+
+  /**
+   * Cells of every city, in the order in which they are found, and city of
+   * every cell (index i*cols() + j), or -1 for cells out of cities. Shared
+   * as distances_.
+   */
+  mutable shared_ptr<const vector< vector<Pos> > > cities_;
+  mutable shared_ptr<const vector<int> > city_index_;
+
+  /**
+   * Summed-area tables of the units, see prefix_count(). Rebuilt every
+   * round, and shared by all copies of the state of that round. 16 bits
+   * are enough for any count, and halve the time to build them.
+   */
+  shared_ptr<const vector<uint16_t> > prefix_counts_;
+
+  /**
+   * Number of 64-bit words of every row of the occupancy bitboards.
+   */
+  inline int row_words () const {
+    return (cols() + 63)/64;
+  }
+
+  /**
+   * Returns the bits of word w that belong to the columns from j0 to j1.
+   */
+  inline static uint64_t window (int w, int j0, int j1) {
+    int lo = max(j0 - 64*w, 0);
+    int hi = min(j1 - 64*w, 63);
+    return (~uint64_t(0) >> (63 - hi)) & (~uint64_t(0) << lo);
+  }
+
+  /**
+   * Number of tables of prefix_counts_ that are summed at once.
+   */
+  static const int LANES = 8;
+
+  /**
+   * Number of entries of every cell of prefix_counts_: one per player and
+   * type of unit, padded to a multiple of LANES.
+   */
+  inline int prefix_stride () const {
+    return (num_cities_.size()*UnitTypeSize + LANES - 1)/LANES*LANES;
+  }
+
+  /**
+   * Rebuilds the occupancy bitboards, the buckets, the summed-area tables
+   * and the warriors in every city from unit_.
+   */
+  void index_units ();
+
+protected:
+
+  /**
+   * Computes the distance fields of the current grid.
+   */
+  void compute_distances () const;
+
+  /**
+   * Chooses the landmarks of the current grid and computes their tables.
+   */
+  void compute_landmarks () const;
+
+  /**
+   * Computes the passability grids of the current grid.
+   */
+  void compute_passable () const;
+
+  /**
+   * Detects the cities of the current grid: the groups of City cells
+   * connected horizontally or vertically, from top to bottom.
+   */
+  void compute_cities () const;
+
+  /**
+   * Sets the cells of every city, as read from a checkpoint.
+   */
+  void set_cities (const vector< vector<Pos> >& cities) const;
 
 public:
 
+  /**
+   * Number of landmarks for each type of unit.
+   */
+  static const int LANDMARKS = 8;
+
+  /**
+   * Side of the square buckets in which nearest_units() looks for units.
+   */
+  static const int BUCKET = 8;
+
   /**
    * Returns the cell defined by the char c.
    */
@@ -56,7 +169,7 @@ public:
    * Reads the grid of the board.
    */
   void read_grid (istream& is) {
-    grid_ = vector< vector<Cell> >(rows(), vector<Cell>(cols()));
+    grid_.assign(rows(), cols());
     for (int i = 0; i < rows(); ++i) {
       string s;
       is >> s;
@@ -64,6 +177,11 @@ public:
                  "The read map has a line with incorrect length.");
       for (int j = 0; j < cols(); ++j) grid_[i][j] = char2cell(s[j]);
     }
+    distances_.reset();
+    landmarks_.reset();
+    passable_.reset();
+    cities_.reset();
+    city_index_.reset();
   }
 
   /**
@@ -76,8 +194,243 @@ public:
       _my_assert(ut_ok(tp), "Wrong unit type on vectors update.");
       (tp == Warrior ? warriors_ : cars_)[u.player].push_back(u.id);
     }
+    index_units();
+  }
+
+  /**
+   * Prints some information of the unit.
+   */
+  inline static void print_unit (Unit u, ostream& os) {
+    os << ut2char(u.type) << ' '
+       << u.player << ' '
+       << u.pos.i << ' '
+       << u.pos.j << ' '
+       << u.food << ' '
+       << u.water << endl;
+  }
+
+  /**
+   * Prints the state of the board to a stream.
+   */
+  void print_state (ostream& os) const;
+
+  /**
+   * Returns the distance field to the cells of type t for units of type ut:
+   * for every cell (index i*cols() + j), the number of moves needed to
+   * reach the closest cell of type t. Warriors move through Desert, Road
+   * and City cells, and cars through Desert and Road cells, but the cells
+   * of type t are reached even if they cannot be entered (as Water).
+   * Unreachable cells have distance -1.
+   */
+  const vector<int>& distance_field (CellType t, UnitType ut) const {
+    if (not distances_) compute_distances();
+    return (*distances_)[t*UnitTypeSize + ut];
+  }
+
+  /**
+   * Returns the distance from p to the closest cell of type t for units
+   * of type ut, or -1 if there is none (see distance_field).
+   */
+  inline int distance (Pos p, CellType t, UnitType ut) const {
+    if (not pos_ok(p)) {
+      _log_warning(LogState, "distance requested for position " << p);
+      return -1;
+    }
+    return distance_field(t, ut)[p.i*cols() + p.j];
+  }
+
+  /**
+   * Returns a lower bound of the number of moves that a unit of type ut
+   * needs to go from a to b, or -1 if it cannot go at all. a and b must be
+   * cells where the unit can stand. Takes O(LANDMARKS) time, with tables
+   * of distances to a few landmarks that are computed once per game.
+   * See Path_finder::moves() for the exact number of moves.
+   */
+  int distance_bound (Pos a, Pos b, UnitType ut) const;
+
+  /**
+   * Returns the word w of row i of the occupancy bitboard of the units of
+   * type ut of player pl (of every player if pl is -1): its bit b is set
+   * if there is such a unit at (i, 64*w + b). Rows with at most 64 columns
+   * have a single word. Updated every round.
+   */
+  inline uint64_t occupancy (int pl, UnitType ut, int i, int w = 0) const {
+    if (pl < -1 or pl >= (int)num_cities_.size() or not ut_ok(ut)
+        or i < 0 or i >= rows() or w < 0 or w >= row_words()) {
+      _log_warning(LogState, "occupancy requested for " << pl << ' ' << ut
+                   << ' ' << i << ' ' << w);
+      return 0;
+    }
+    if (pl == -1) {
+      uint64_t bits = 0;
+      for (int q = 0; q < (int)num_cities_.size(); ++q)
+        bits |= occupancy(q, ut, i, w);
+      return bits;
+    }
+    return occupancy_[((pl*UnitTypeSize + ut)*rows() + i)*row_words() + w];
   }
 
+  /**
+   * Calls f(q) for the position q of every unit of type ut of player pl
+   * (of every player if pl is -1) at distance at most r from p, with
+   * distance max(|di|, |dj|), row by row. Takes O(r) time plus O(1) per
+   * unit found.
+   */
+  template <class F>
+  void for_each_in_radius (Pos p, int r, int pl, UnitType ut, F f) const {
+    int i1 = min(rows() - 1, p.i + r);
+    int j0 = max(0, p.j - r);
+    int j1 = min(cols() - 1, p.j + r);
+    for (int i = max(0, p.i - r); i <= i1; ++i)
+      for (int w = j0/64; w <= j1/64 and j0 <= j1; ++w) {
+        uint64_t bits = occupancy(pl, ut, i, w) & window(w, j0, j1);
+        while (bits) {
+          f(Pos(i, 64*w + __builtin_ctzll(bits)));
+          bits &= bits - 1;
+        }
+      }
+  }
+
+  /**
+   * Returns the number of units of type ut of player pl (of every player
+   * if pl is -1) in rows 0 to i - 1 and columns 0 to j - 1, for i from 0
+   * to rows() and j from 0 to cols(). Updated every round.
+   */
+  inline int prefix_count (int i, int j, int pl, UnitType ut) const {
+    if (pl < -1 or pl >= (int)num_cities_.size() or not ut_ok(ut)
+        or i < 0 or i > rows() or j < 0 or j > cols()) {
+      _log_warning(LogState, "prefix count requested for " << pl << ' ' << ut
+                   << ' ' << i << ' ' << j);
+      return 0;
+    }
+    int np = num_cities_.size();
+    const uint16_t* t = &(*prefix_counts_)[(i*(cols() + 1) + j)*prefix_stride()];
+    if (pl != -1) return t[pl*UnitTypeSize + ut];
+    int count = 0;
+    for (int q = 0; q < np; ++q) count += t[q*UnitTypeSize + ut];
+    return count;
+  }
+
+  /**
+   * Returns the number of units of type ut of player pl (of every player
+   * if pl is -1) in rows i0 to i1 and columns j0 to j1, clipped to the
+   * board. Takes O(1) time.
+   */
+  inline int count_in_window (int i0, int j0, int i1, int j1,
+                              int pl, UnitType ut) const {
+    i0 = max(i0, 0);
+    j0 = max(j0, 0);
+    i1 = min(i1, rows() - 1) + 1;
+    j1 = min(j1, cols() - 1) + 1;
+    if (i0 >= i1 or j0 >= j1) return 0;
+    return prefix_count(i1, j1, pl, ut) - prefix_count(i0, j1, pl, ut)
+         - prefix_count(i1, j0, pl, ut) + prefix_count(i0, j0, pl, ut);
+  }
+
+  /**
+   * Returns the number of units of type ut of player pl (of every player
+   * if pl is -1) at distance at most r from p (see for_each_in_radius).
+   * Takes O(1) time.
+   */
+  inline int count_in_radius (Pos p, int r, int pl, UnitType ut) const {
+    return count_in_window(p.i - r, p.j - r, p.i + r, p.j + r, pl, ut);
+  }
+
+  /**
+   * Returns whether a unit of type ut can stand on the cell at p: Desert
+   * and Road cells, and also City cells for warriors. False outside the
+   * board.
+   */
+  inline bool can_stand (Pos p, UnitType ut) const {
+    if (not passable_) compute_passable();
+    if (not ut_ok(ut)) return false;
+    if (p.i < -1 or p.i > rows() or p.j < -1 or p.j > cols()) return false;
+    return (*passable_)[ut][(p.i + 1)*(cols() + 2) + p.j + 1];
+  }
+
+  /**
+   * Returns the cells of type t, as a bitboard (see bfs_layers).
+   */
+  Bitboard cells_of (CellType t) const;
+
+  /**
+   * Returns the cells where a unit of type ut can stand (see can_stand).
+   */
+  Bitboard passable_cells (UnitType ut) const;
+
+  /**
+   * Returns the cells with a unit of type ut of player pl (of every player
+   * if pl is -1). Updated every round.
+   */
+  Bitboard unit_cells (int pl, UnitType ut) const;
+
+  /**
+   * Returns the directions in which unit id can be moved this round, as a
+   * mask with bit d set if a command to move in direction d would be done.
+   * Bit None is always set, and is the only one for units that cannot move
+   * (see can_move). A move onto another unit is an attack, and is done;
+   * movements done before in the same round can change the result.
+   * Returns 0 for a wrong id.
+   */
+  int legal_moves (int id) const;
+
+  /**
+   * Same as above, for every unit in ids, whose masks are stored in masks
+   * in a single pass over the units.
+   */
+  void legal_moves (const vector<int>& ids, vector<int>& masks) const;
+
+  /**
+   * Returns the cells of every city. The cities are numbered in the order
+   * in which they are found, from top to bottom and left to right.
+   */
+  const vector< vector<Pos> >& cities () const {
+    if (not cities_) compute_cities();
+    return *cities_;
+  }
+
+  /**
+   * Returns the city of every cell (index i*cols() + j), or -1 for the
+   * cells that are not in a city.
+   */
+  const vector<int>& city_index () const {
+    if (not city_index_) compute_cities();
+    return *city_index_;
+  }
+
+  /**
+   * Returns the city of the cell at p, or -1 if it is not in a city.
+   */
+  inline int city_of (Pos p) const {
+    if (not pos_ok(p)) {
+      _log_warning(LogState, "city requested for position " << p);
+      return -1;
+    }
+    return city_index()[p.i*cols() + p.j];
+  }
+
+  /**
+   * Returns the number of warriors of player pl in city c. Updated every
+   * round.
+   */
+  inline int city_warriors (int c, int pl) const {
+    int np = num_cities_.size();
+    if (c < 0 or c*np >= (int)city_warriors_.size() or pl < 0 or pl >= np) {
+      _log_warning(LogState, "warriors requested for city " << c
+                   << " and player " << pl);
+      return 0;
+    }
+    return city_warriors_[c*np + pl];
+  }
+
+  /**
+   * Returns the identifiers of the k units of type ut of player pl (of
+   * every player if pl is -1) closest to p, with distance max(|di|, |dj|),
+   * from the closest one; ties are broken by identifier. Returns fewer if
+   * there are not so many. Only looks in the buckets around p.
+   */
+  vector<int> nearest_units (Pos p, int k, int pl, UnitType ut) const;
+
 };
 
 
@@ -0,0 +1,47 @@
+#include "Log.hh"
+
+#include <mutex>
+
+
+int    Log::level_      = LOG_LEVEL;
+int    Log::categories_ = (1 << LogCategorySize) - 1;
+string Log::buffer_;
+
+
+/**
+ * Players may run in their own threads (see Watchdog).
+ */
+static mutex log_mutex_;
+
+
+/**
+ * Writes the buffer to cerr. The caller must hold log_mutex_.
+ */
+static void write_buffer (string& buffer) {
+  cerr.write(buffer.data(), buffer.size());
+  cerr.flush();
+  buffer.clear();
+}
+
+
+void Log::write (int level, const string& line) {
+  lock_guard<mutex> lock(log_mutex_);
+  buffer_ += line;
+  if (level == LOG_ERROR or (int)buffer_.size() >= FLUSH_SIZE)
+    write_buffer(buffer_);
+}
+
+
+void Log::flush () {
+  lock_guard<mutex> lock(log_mutex_);
+  if (not buffer_.empty()) write_buffer(buffer_);
+}
+
+
+/**
+ * Writes whatever is left in the buffer when the program ends.
+ * Defined after buffer_ so that it is destroyed before it.
+ */
+static struct Log_flusher {
+  ~Log_flusher () { Log::flush(); }
+} log_flusher_;
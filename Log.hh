@@ -0,0 +1,142 @@
+#ifndef Log_hh
+#define Log_hh
+
+
+#include "Utils.hh"
+
+
+/** \file
+ * Contains a leveled and categorized logging facility.
+ *
+ * Messages are written through the _log_error, _log_warning, _log_info and
+ * _log_debug macros. Levels above LOG_LEVEL are removed by the preprocessor,
+ * so they cost nothing at all. The remaining ones can still be filtered at
+ * run time, and are buffered and written to cerr in large blocks.
+ */
+
+
+/**
+ * Log levels, from most to least important.
+ */
+#define LOG_ERROR   0
+#define LOG_WARNING 1
+#define LOG_INFO    2
+#define LOG_DEBUG   3
+
+
+/**
+ * Highest level that is compiled in. Can be given with -DLOG_LEVEL=n.
+ */
+#ifndef LOG_LEVEL
+#  ifdef DEBUG
+#    define LOG_LEVEL LOG_DEBUG
+#  else
+#    define LOG_LEVEL LOG_INFO
+#  endif
+#endif
+
+
+/**
+ * Defines the part of the program a message comes from.
+ */
+enum LogCategory {
+  LogGame, LogBoard, LogState, LogAction,
+  LogCategorySize
+};
+
+
+/**
+ * Buffers the log messages and decides which ones are written.
+ */
+class Log {
+
+  /**
+   * Size of the buffer that triggers a write to cerr.
+   */
+  static const int FLUSH_SIZE = 1 << 16;
+
+  static int level_;
+  static int categories_;
+  static string buffer_;
+
+public:
+
+  /**
+   * Returns whether messages of this level and category are written.
+   */
+  inline static bool enabled (int level, LogCategory cat) {
+    return level <= level_ and (categories_ >> cat & 1);
+  }
+
+  /**
+   * Sets the highest level written at run time.
+   */
+  inline static void set_level (int level) {
+    level_ = level;
+  }
+
+  /**
+   * Enables or disables a category at run time.
+   */
+  inline static void set_category (LogCategory cat, bool on) {
+    if (on) categories_ |= 1 << cat;
+    else categories_ &= ~(1 << cat);
+  }
+
+  /**
+   * Returns the prefix of a message of the given level.
+   */
+  inline static const char* prefix (int level) {
+    static const char* s[] = { "error: ", "warning: ", "info: ", "debug: " };
+    return s[level];
+  }
+
+  /**
+   * Appends a finished line to the buffer, writing it out if it is full.
+   * Errors are written at once, since the program may be about to abort.
+   */
+  static void write (int level, const string& line);
+
+  /**
+   * Writes all the buffered messages to cerr.
+   */
+  static void flush ();
+
+};
+
+
+/**
+ * Logs msg (anything that can be sent to an ostream) with a given level.
+ * Like the per-level macros below, it is a single statement that takes a
+ * semicolon, also where it is disabled, so it can be used in an if-else.
+ */
+#define _log(level, cat, msg) do { if (Log::enabled(level, cat)) { \
+        ostringstream _oss; _oss << Log::prefix(level) << msg << '\n'; \
+        Log::write(level, _oss.str()); } } while (0)
+
+#if LOG_LEVEL >= LOG_ERROR
+#  define _log_error(cat, msg) _log(LOG_ERROR, cat, msg)
+#else
+#  define _log_error(cat, msg) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_WARNING
+#  define _log_warning(cat, msg) _log(LOG_WARNING, cat, msg)
+#else
+#  define _log_warning(cat, msg) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_INFO
+#  define _log_info(cat, msg) _log(LOG_INFO, cat, msg)
+#else
+#  define _log_info(cat, msg) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_DEBUG
+#  define _log_debug(cat, msg) _log(LOG_DEBUG, cat, msg)
+#else
+#  define _log_debug(cat, msg) do { } while (0)
+#endif
+
+
+#endif
@@ -1,4 +1,7 @@
 #include "Game.hh"
+#include "Watchdog.hh"
+
+#include <unistd.h>
 
 
 void help (int argc, char** argv) {
@@ -7,6 +10,14 @@ void help (int argc, char** argv) {
   cout << "--seed=seed     -s seed     set random seed"                   << endl;
   cout << "--input=file    -i input    set input file  (default: stdin)"  << endl;
   cout << "--output=file   -o output   set output file (default: stdout)" << endl;
+  cout << "--time=secs     -t secs     cpu time limit for each player"    << endl;
+  cout << "--round=secs    -r secs     wall time limit for each round"    << endl;
+  cout << "--save=file     -S file     save a checkpoint of the game"     << endl;
+  cout << "--at=round      -a round    round of the checkpoint (default: 0)" << endl;
+  cout << "--resume=file   -R file     resume the game from a checkpoint" << endl;
+  cout << "--games=n       -g n        play n games, printing only their results" << endl;
+  cout << "--seed-start=s  -f s        seed of the first game (default: seed)" << endl;
+  cout << "--log=level     -L level    set log level (0 error .. 3 debug)" << endl;
   cout << "--list          -l          list registered players"           << endl;
   cout << "--version       -v          print version"                     << endl;
   cout << "--help          -h          print help"                        << endl;
@@ -23,6 +34,14 @@ int main (int argc, char** argv) {
     { "seed",    required_argument, 0, 's' },
     { "input",   required_argument, 0, 'i' },
     { "output",  required_argument, 0, 'o' },
+    { "time",    required_argument, 0, 't' },
+    { "round",   required_argument, 0, 'r' },
+    { "save",    required_argument, 0, 'S' },
+    { "at",      required_argument, 0, 'a' },
+    { "resume",  required_argument, 0, 'R' },
+    { "games",   required_argument, 0, 'g' },
+    { "seed-start", required_argument, 0, 'f' },
+    { "log",     required_argument, 0, 'L' },
     { "list",    no_argument,       0, 'l' },
     { "version", no_argument,       0, 'v' },
     { "help",    no_argument,       0, 'h' },
@@ -32,11 +51,13 @@ int main (int argc, char** argv) {
   char* ifile = 0;
   char* ofile = 0;
   int seed = -1;
+  int games = 0;
+  Game_options opt;
   vector<string> names;
 
   while (true) {
     int index = 0;
-    int c = getopt_long(argc, argv, "s:i:o:lvh", long_options, &index);
+    int c = getopt_long(argc, argv, "s:i:o:t:r:S:a:R:g:f:L:lvh", long_options, &index);
     if (c == -1) break;
 
     switch (c) {
@@ -49,6 +70,30 @@ int main (int argc, char** argv) {
       case 'o':
         ofile = optarg;
         break;
+      case 't':
+        opt.cpu_time = string_to_double(optarg);
+        break;
+      case 'r':
+        opt.round_time = string_to_double(optarg);
+        break;
+      case 'S':
+        opt.save_file = optarg;
+        break;
+      case 'a':
+        opt.save_round = string_to_int(optarg);
+        break;
+      case 'R':
+        opt.resume_file = optarg;
+        break;
+      case 'g':
+        games = string_to_int(optarg);
+        break;
+      case 'f':
+        seed = string_to_int(optarg);
+        break;
+      case 'L':
+        Log::set_level(string_to_int(optarg));
+        break;
       case 'l':
         Registry::print_players(cout);
         return EXIT_SUCCESS;
@@ -69,13 +114,24 @@ int main (int argc, char** argv) {
     _my_assert(names.back().size() <= 12, "Player name too long.");
   }
 
-  _my_assert(seed >= 0, "Missing seed?");
+  _my_assert(seed >= 0 or not opt.resume_file.empty(), "Missing seed?");
 
   istream* is = ifile ? new ifstream(ifile) : &cin;
   ostream* os = ofile ? new ofstream(ofile) : &cout;
 
-  Game::run(names, *is, *os, seed);
+  if (games > 0) {
+    _my_assert(seed >= 0, "Missing seed?");
+    Game::run_batch(names, *is, *os, seed, games, opt);
+  }
+  else Game::run(names, *is, *os, seed, opt);
 
   if (ifile) delete is;
   if (ofile) delete os;
+
+  // Players that exceeded their time limit may still be running.
+  if (Watchdog::runaway() > 0) {
+    cout.flush();
+    Log::flush();
+    _exit(EXIT_SUCCESS);
+  }
 }
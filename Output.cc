@@ -0,0 +1,72 @@
+#include "Output.hh"
+
+
+Output_stage::Output_stage (ostream& os)
+  : os_(os), busy_(false), closed_(false) {
+  for (int k = 0; k < MAX_FRAMES; ++k) {
+    frames_.push_back(new Frame());
+    free_.push_back(frames_.back());
+  }
+  writer_ = thread(&Output_stage::work, this);
+}
+
+
+Output_stage::~Output_stage () {
+  {
+    lock_guard<mutex> lock(m_);
+    closed_ = true;
+  }
+  cv_.notify_all();
+  writer_.join();
+  for (Frame* f : frames_) delete f;
+}
+
+
+void Output_stage::push (const vector<Movement>& done, const Info& info) {
+  unique_lock<mutex> lock(m_);
+  cv_.wait(lock, [this] { return not free_.empty(); });
+  Frame* f = free_.back();
+  free_.pop_back();
+  lock.unlock();
+
+  // Copying into a used frame reuses the storage of its vectors.
+  f->done = done;
+  f->info = info;
+
+  lock.lock();
+  full_.push_back(f);
+  cv_.notify_all();
+}
+
+
+void Output_stage::flush () {
+  unique_lock<mutex> lock(m_);
+  cv_.wait(lock, [this] { return full_.empty() and not busy_; });
+  os_.flush();
+}
+
+
+void Output_stage::work () {
+  // Each round is formatted in memory and written at once.
+  ostringstream oss;
+  unique_lock<mutex> lock(m_);
+  while (true) {
+    cv_.wait(lock, [this] { return closed_ or not full_.empty(); });
+    if (full_.empty()) return;
+    Frame* f = full_.front();
+    full_.pop_front();
+    busy_ = true;
+    lock.unlock();
+
+    oss.str("");
+    Board::print_movements(f->done, oss);
+    f->info.print_state(oss);
+    string s = oss.str();
+    os_.write(s.data(), s.size());
+
+    lock.lock();
+    busy_ = false;
+    free_.push_back(f);
+    cv_.notify_all();
+  }
+}
@@ -0,0 +1,77 @@
+#ifndef Output_hh
+#define Output_hh
+
+
+#include "Board.hh"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+/** \file
+ * Contains a class to write the trace of a game in a separate thread.
+ */
+
+
+/**
+ * Formats and writes the movements and the state of every round in its
+ * own thread, so that the players can already compute the next round.
+ *
+ * Each round is handed over as a copy of the state (a frame). Frames are
+ * recycled, so that their storage is allocated only once.
+ */
+class Output_stage {
+
+  /**
+   * Maximum number of rounds waiting to be written.
+   */
+  static const int MAX_FRAMES = 4;
+
+  struct Frame {
+    vector<Movement> done;
+    Info info;
+  };
+
+  ostream& os_;
+  mutex m_;
+  condition_variable cv_;
+  vector<Frame*> frames_;  // All the frames, to delete them.
+  deque<Frame*> full_;     // Frames waiting to be written, in order.
+  vector<Frame*> free_;    // Frames that can be reused.
+  bool busy_;              // Whether the writer is writing a frame.
+  bool closed_;
+  thread writer_;
+
+  /**
+   * Main loop of the writer thread.
+   */
+  void work ();
+
+public:
+
+  /**
+   * Starts the writer thread.
+   */
+  Output_stage (ostream& os);
+
+  /**
+   * Writes everything pending and stops the writer thread.
+   */
+  ~Output_stage ();
+
+  /**
+   * Queues a round to be written: the movements done and the resulting
+   * state. Only waits if too many rounds are already pending.
+   */
+  void push (const vector<Movement>& done, const Info& info);
+
+  /**
+   * Waits until everything queued has been written.
+   */
+  void flush ();
+
+};
+
+
+#endif
@@ -0,0 +1,75 @@
+#include "Path.hh"
+
+
+void Path_finder::begin (int start) {
+  int n = info_.rows()*info_.cols();
+  if ((int)stamp_.size() != n) {
+    stamp_ = vector<unsigned>(n, 0);
+    dist_ = parent_ = source_ = vector<int>(n);
+    heap_.reserve(8*n);
+    gen_ = 0;
+  }
+
+  // When the generations wrap around, old stamps could look current.
+  if (++gen_ == 0) {
+    fill(stamp_.begin(), stamp_.end(), 0);
+    gen_ = 1;
+  }
+
+  start_ = start;
+}
+
+
+int Path_finder::moves (Pos a, Pos b, UnitType ut) {
+  if (info_.distance_bound(a, b, ut) == -1) return -1;
+  return guided(a, b, ut, [] (Pos, Pos) { return 1; },
+                [this, b, ut] (Pos p) { return info_.distance_bound(p, b, ut); });
+}
+
+
+int Path_finder::distance (Pos p) const {
+  if (start_ == -1 or not info_.pos_ok(p) or not reached(index(p))) return -1;
+  return dist_[index(p)];
+}
+
+
+int Path_finder::source (Pos p) const {
+  if (distance(p) == -1) return -1;
+  return source_[index(p)];
+}
+
+
+Pos Path_finder::parent (Pos p) const {
+  if (distance(p) == -1) return Pos(-1, -1);
+  return pos(parent_[index(p)]);
+}
+
+
+Dir Path_finder::first_step (Pos p) const {
+  if (distance(p) == -1) return None;
+  // The starts are their own parents.
+  int k = index(p);
+  if (parent_[k] == k) return None;
+  while (parent_[parent_[k]] != parent_[k]) k = parent_[k];
+
+  Pos s = pos(parent_[k]);
+  Pos q = pos(k);
+  for (int d = 0; d < 8; ++d)
+    if (s + Dir(d) == q) return Dir(d);
+  _unreachable();
+  return None;
+}
+
+
+vector<Pos> Path_finder::path (Pos p) const {
+  vector<Pos> v;
+  if (distance(p) == -1) return v;
+  int k = index(p);
+  v.push_back(p);
+  while (parent_[k] != k) {
+    k = parent_[k];
+    v.push_back(pos(k));
+  }
+  reverse(v.begin(), v.end());
+  return v;
+}
@@ -0,0 +1,292 @@
+#ifndef Path_hh
+#define Path_hh
+
+
+#include "Info.hh"
+
+#include <climits>
+
+
+/** \file
+ * Contains a class to find paths on the board.
+ */
+
+
+/**
+ * Dijkstra and A* searches on the board, for the players.
+ *
+ * Units move to the 8 neighbours of their cell: warriors through Desert,
+ * Road and City cells, and cars through Desert and Road cells. The cost of
+ * every step is given by a callback cost(from, to), which returns -1 to
+ * forbid it. Cells at the same distance are settled from the last one (in
+ * row-major order) to the first.
+ *
+ * The buffers are flat arrays, allocated once and reused by every search:
+ * a generation stamp tells which of their entries belong to the current
+ * one. The distances, first steps and paths of the last search can be
+ * queried until the next one starts.
+ *
+ * When the steps cost between 1 and some small max_cost, dial() does the
+ * same as dijkstra() with a bucket queue instead of a heap, and can start
+ * from several cells at once.
+ */
+class Path_finder {
+
+  struct Entry {
+    int key;   // Distance plus heuristic.
+    int dist;
+    int k;     // Index of the cell.
+  };
+
+  const Info& info_;
+  unsigned gen_;            // Generation of the current search.
+  vector<unsigned> stamp_;  // Generation in which dist_ and parent_ were set.
+  vector<int> dist_;
+  vector<int> parent_;
+  vector<int> source_;      // Start from which every cell was reached.
+  vector<Entry> heap_;
+  vector< vector<int> > buckets_;  // Cells by distance modulo max_cost + 1.
+  int start_;
+
+  static bool later (const Entry& a, const Entry& b) {
+    if (a.key != b.key) return a.key > b.key;
+    return a.k < b.k;
+  }
+
+  inline int index (Pos p) const {
+    return p.i*info_.cols() + p.j;
+  }
+
+  inline Pos pos (int k) const {
+    return Pos(k/info_.cols(), k%info_.cols());
+  }
+
+  inline bool reached (int k) const {
+    return stamp_[k] == gen_;
+  }
+
+  static bool passable (UnitType ut, CellType t) {
+    return t == Desert or t == Road or (t == City and ut == Warrior);
+  }
+
+  /**
+   * Starts a new generation, for a search from start (-1 if several).
+   */
+  void begin (int start);
+
+  /**
+   * Sets the cell k, the start number s of the search, at distance 0.
+   */
+  inline void set_start (int k, int s) {
+    stamp_[k] = gen_;
+    dist_[k] = 0;
+    parent_[k] = k;
+    source_[k] = s;
+  }
+
+  /**
+   * Settles cells in order of distance plus heuristic h, calling visit(p,
+   * dist) for each of them, until it returns true. Only reaches the cells
+   * at a distance smaller than limit.
+   */
+  template <class Cost, class Visit, class Heuristic>
+  void run (Pos start, UnitType ut, Cost cost, Visit visit, Heuristic h,
+            int limit);
+
+public:
+
+  /**
+   * Creates a path finder on the board of info.
+   */
+  Path_finder (const Info& info) : info_(info), gen_(0), start_(-1) { }
+
+  /**
+   * Dijkstra from start, for units of type ut. Calls visit(p, dist) for
+   * every cell reached, in order of distance, and stops when it returns
+   * true. Only reaches the cells at a distance smaller than limit.
+   */
+  template <class Cost, class Visit>
+  void dijkstra (Pos start, UnitType ut, Cost cost, Visit visit,
+                 int limit = INT_MAX) {
+    run(start, ut, cost, visit, [](Pos) { return 0; }, limit);
+  }
+
+  /**
+   * Same as dijkstra, but every step must cost between 1 and max_cost, and
+   * the cells are kept in max_cost + 1 buckets, by distance, instead of a
+   * heap. The cells are settled in the same order, so it gives the same
+   * results, faster when max_cost is small.
+   */
+  template <class Cost, class Visit>
+  void dial (Pos start, UnitType ut, Cost cost, Visit visit, int max_cost,
+             int limit = INT_MAX) {
+    dial(vector<Pos>(1, start), ut, cost, visit, max_cost, limit);
+  }
+
+  /**
+   * Same as above, from all the cells of starts at once: every cell is
+   * reached from its closest start (see source), and its first step and
+   * path begin there.
+   */
+  template <class Cost, class Visit>
+  void dial (const vector<Pos>& starts, UnitType ut, Cost cost, Visit visit,
+             int max_cost, int limit = INT_MAX);
+
+  /**
+   * A* from start to goal, for units of type ut. min_cost must be at most
+   * the cost of any step, so that the search is exact. Returns the distance
+   * to goal, or -1 if it cannot be reached.
+   */
+  template <class Cost>
+  int a_star (Pos start, Pos goal, UnitType ut, Cost cost, int min_cost = 1) {
+    return guided(start, goal, ut, cost, [goal, min_cost] (Pos p) {
+      return min_cost*max(abs(p.i - goal.i), abs(p.j - goal.j));
+    });
+  }
+
+  /**
+   * Same as a_star, with a heuristic h(p) that must be a consistent lower
+   * bound of the distance from p to goal.
+   */
+  template <class Cost, class Heuristic>
+  int guided (Pos start, Pos goal, UnitType ut, Cost cost, Heuristic h) {
+    bool found = false;
+    run(start, ut, cost,
+        [&found, goal] (Pos p, int) { return found = (p == goal); },
+        h, INT_MAX);
+    return found ? dist_[index(goal)] : -1;
+  }
+
+  /**
+   * Returns the exact number of moves that a unit of type ut needs to go
+   * from a to b, or -1 if it cannot. Guided by the landmarks of the board
+   * (see Info::distance_bound), so it explores few cells beyond the path.
+   */
+  int moves (Pos a, Pos b, UnitType ut);
+
+  /**
+   * Returns the distance to p in the last search, or -1 if not reached.
+   */
+  int distance (Pos p) const;
+
+  /**
+   * Returns the index of the start from which p was reached in the last
+   * search (0 if it had a single start), or -1 if not reached.
+   */
+  int source (Pos p) const;
+
+  /**
+   * Returns the previous cell of the path to p in the last search (the
+   * start for the start itself), or (-1, -1) if p was not reached.
+   */
+  Pos parent (Pos p) const;
+
+  /**
+   * Returns the direction of the first step of the path to p in the last
+   * search, or None if p is a start or was not reached.
+   */
+  Dir first_step (Pos p) const;
+
+  /**
+   * Returns the cells of the path to p in the last search, from the start
+   * to p, or an empty path if p was not reached.
+   */
+  vector<Pos> path (Pos p) const;
+
+};
+
+
+template <class Cost, class Visit, class Heuristic>
+void Path_finder::run (Pos start, UnitType ut, Cost cost, Visit visit,
+                       Heuristic h, int limit) {
+  begin(index(start));
+  heap_.clear();
+  set_start(start_, 0);
+  heap_.push_back(Entry{h(start), 0, start_});
+  while (not heap_.empty()) {
+    pop_heap(heap_.begin(), heap_.end(), later);
+    Entry e = heap_.back();
+    heap_.pop_back();
+    if (e.dist != dist_[e.k]) continue; // already settled closer
+
+    Pos p = pos(e.k);
+    if (visit(p, e.dist)) return;
+
+    for (int d = 0; d < 8; ++d) {
+      Pos q = p + Dir(d);
+      if (not info_.pos_ok(q)
+          or not passable(ut, info_.cell_ref(q).type)) continue;
+      int c = cost(p, q);
+      if (c < 0 or e.dist + c >= limit) continue;
+      int kq = index(q);
+      int dq = e.dist + c;
+      if (not reached(kq) or dq < dist_[kq]) {
+        stamp_[kq] = gen_;
+        dist_[kq] = dq;
+        parent_[kq] = e.k;
+        source_[kq] = source_[e.k];
+        heap_.push_back(Entry{dq + h(q), dq, kq});
+        push_heap(heap_.begin(), heap_.end(), later);
+      }
+    }
+  }
+}
+
+
+template <class Cost, class Visit>
+void Path_finder::dial (const vector<Pos>& starts, UnitType ut, Cost cost,
+                        Visit visit, int max_cost, int limit) {
+  _my_assert(max_cost >= 1, "Steps must cost at least 1.");
+  int B = max_cost + 1;
+  begin(starts.size() == 1 ? index(starts[0]) : -1);
+  if ((int)buckets_.size() < B) buckets_.resize(B);
+  for (int b = 0; b < B; ++b) buckets_[b].clear();
+
+  int pending = 0;
+  for (int s = 0; s < (int)starts.size(); ++s) {
+    int k = index(starts[s]);
+    if (reached(k)) continue;
+    if (start_ == -1) start_ = k;
+    set_start(k, s);
+    buckets_[0].push_back(k);
+    ++pending;
+  }
+
+  // All the pending cells are at distances dist, ..., dist + max_cost, so
+  // each bucket holds a single distance. Within it, cells are settled from
+  // the last one to the first, as dijkstra does.
+  for (int dist = 0; pending > 0; ++dist) {
+    vector<int>& bucket = buckets_[dist%B];
+    pending -= bucket.size();
+    sort(bucket.begin(), bucket.end(), greater<int>());
+    for (int k : bucket) {
+      if (dist_[k] != dist) continue; // already settled closer
+
+      Pos p = pos(k);
+      if (visit(p, dist)) return;
+
+      for (int d = 0; d < 8; ++d) {
+        Pos q = p + Dir(d);
+        if (not info_.pos_ok(q)
+            or not passable(ut, info_.cell_ref(q).type)) continue;
+        int c = cost(p, q);
+        if (c < 0 or dist + c >= limit) continue;
+        _my_assert(c >= 1 and c <= max_cost, "Step cost out of range.");
+        int kq = index(q);
+        int dq = dist + c;
+        if (not reached(kq) or dq < dist_[kq]) {
+          stamp_[kq] = gen_;
+          dist_[kq] = dq;
+          parent_[kq] = k;
+          source_[kq] = source_[k];
+          buckets_[dq%B].push_back(kq);
+          ++pending;
+        }
+      }
+    }
+    bucket.clear();
+  }
+}
+
+
+#endif
@@ -3,6 +3,8 @@
 
 void Player::reset (ifstream& is) {
   *(Action*)this = Action();
+  ++plays_;
+  arena_.clear();
 
   read_grid(is);
 
@@ -35,6 +37,8 @@ void Player::reset (ifstream& is) {
     assert(st == -1 or (st >= 0 and st <= 1));
   }
 
+  // The changes of the last round are not part of the printed state.
+  delta_ = Round_delta();
   unit_ = vector<Unit>(nb_players()*(nb_warriors() + nb_cars()));
 
   for (int id = 0; id < nb_units(); ++id) {
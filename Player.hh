@@ -6,6 +6,10 @@
 #include "Action.hh"
 #include "Random.hh"
 #include "Registry.hh"
+#include "Path.hh"
+#include "Simulator.hh"
+#include "Arena.hh"
+#include "Eval.hh"
 
 
 /***
@@ -21,18 +25,41 @@ class Player : public Info, public Random_generator, public Action {
 
   friend class Game;
   friend class SecGame;
+  friend class Bench;
 
   int me_;
+  int plays_; // Number of rounds played by this object.
+  Path_finder path_finder_;
+  Simulator simulator_;
+  Arena arena_;
 
   inline void reset (const Info& info) {
     *static_cast<Action*>(this) = Action();
     *static_cast<State*>(this) = (State)info;
+    distances_ = info.distances_;
+    landmarks_ = info.landmarks_;
+    passable_ = info.passable_;
+    cities_ = info.cities_;
+    city_index_ = info.city_index_;
+    prefix_counts_ = info.prefix_counts_;
+    ++plays_;
+    arena_.clear();
   }
 
   void reset (ifstream& is);
 
 public:
 
+  /**
+   * Default constructor.
+   */
+  Player () : me_(-1), plays_(0), path_finder_(*this) { }
+
+  /**
+   * Players are deleted through a pointer to this class.
+   */
+  virtual ~Player () { }
+
   /**
    * Play intelligence. Will be overwritten, thus declared virtual.
    */
@@ -46,6 +73,38 @@ public:
     return me_;
   }
 
+  /**
+   * Path finder on the current board, with its buffers kept between rounds.
+   */
+  inline Path_finder& paths () {
+    return path_finder_;
+  }
+
+  /**
+   * Simulator of rounds from the current board, with its board kept
+   * between rounds.
+   */
+  inline Simulator& simulator () {
+    return simulator_;
+  }
+
+  /**
+   * Memory for the data of the current round, freed before every play().
+   * See Arena_allocator and Arena_grid.
+   */
+  inline Arena& arena () {
+    return arena_;
+  }
+
+  /**
+   * Returns whether this is the first round played by this player.
+   * It is round 0, unless the game was resumed from a checkpoint,
+   * so use it rather than round() == 0 to initialize your data.
+   */
+  inline bool first_play () const {
+    return plays_ == 1;
+  }
+
 };
 
 
@@ -13,6 +13,8 @@ class Random_generator {
   friend class Board;
   friend class Game;
   friend class SecGame;
+  friend class Bench;
+  friend class Simulator;
 
   static const long long RANDOM_MOD = ((long long)1)<<31;
   static const long long RANDOM_MASC = RANDOM_MOD - 1;
@@ -15,12 +15,24 @@ int Registry::Register (const char* name, Factory factory) {
 
 
 Player* Registry::new_player (string name) {
+  return factory(name)();
+}
+
+
+Registry::Factory Registry::factory (string name) {
   auto it = reg_->find(name);
   _my_assert(it != reg_->end(), "Player " + name + " not registered.");
-  return (it->second)();
+  return it->second;
 }
 
 
 void Registry::print_players (ostream& os) {
-  for (const auto& it : *reg_) cout << it.first << endl;
+  for (const string& name : names()) os << name << endl;
+}
+
+
+vector<string> Registry::names () {
+  vector<string> v;
+  for (const auto& it : *reg_) v.push_back(it.first);
+  return v;
 }
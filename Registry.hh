@@ -27,8 +27,18 @@ public:
 
   static Player* new_player (string name);
 
+  /**
+   * Returns the factory of a player, to create it without looking it up.
+   */
+  static Factory factory (string name);
+
   static void print_players (ostream& os);
 
+  /**
+   * Returns the names of all the registered players, in order.
+   */
+  static vector<string> names ();
+
 };
 
 
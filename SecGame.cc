@@ -0,0 +1,417 @@
+#include "SecGame.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <fcntl.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+
+/**
+ * Offsets (in bytes) of every part of the shared state region.
+ * The region starts with the round number, or -1 to ask the players to quit.
+ * It ends with the tables that never change during a game (the distance
+ * fields, the landmarks and the passability grids of Info), written once.
+ */
+struct SecGame::Layout {
+
+  int rows, cols, nb_units, nb_players, nb_cities;
+  size_t cells, units, num_cities, total_score, status;
+  size_t delta, movements, captures, changes;
+  size_t distances, landmarks, passable, size;
+
+  Layout (const Settings& s)
+    : rows(s.rows()), cols(s.cols()),
+      nb_units(s.nb_players()*(s.nb_warriors() + s.nb_cars())),
+      nb_players(s.nb_players()), nb_cities(s.nb_cities()) {
+    int n = rows*cols;
+    cells       = align(sizeof(int));
+    units       = align(cells + n*sizeof(Cell));
+    num_cities  = align(units + nb_units*sizeof(Unit));
+    total_score = align(num_cities + nb_players*sizeof(int));
+    status      = align(total_score + nb_players*sizeof(int));
+    delta       = align(status + nb_players*sizeof(double));
+    movements   = align(delta + 3*sizeof(int));
+    captures    = align(movements + nb_units*sizeof(Movement));
+    changes     = align(captures + nb_units*sizeof(Capture));
+    distances   = align(changes + nb_cities*sizeof(City_change));
+    landmarks   = align(distances + CellTypeSize*UnitTypeSize*n*sizeof(int));
+    passable    = align(landmarks + UnitTypeSize*Info::LANDMARKS*n*sizeof(int));
+    size        = align(passable + UnitTypeSize*(rows + 2)*(cols + 2));
+  }
+
+  static size_t align (size_t x) {
+    return (x + 63) & ~size_t(63);
+  }
+
+};
+
+
+/**
+ * A movement as sent through the ring buffer. An entry with id -1 ends
+ * the movements of a round, and then dir holds the round number.
+ */
+struct Entry {
+  int id;
+  int dir;
+};
+
+
+/**
+ * Lock-free ring buffer with a single producer (a player process) and a
+ * single consumer (the game), living in shared memory.
+ */
+struct Ring {
+
+  static const unsigned SIZE = 2048; // A power of 2, > Action::MAX_MOVEMENTS.
+
+  atomic<unsigned> head;             // Only written by the consumer.
+  char pad[64 - sizeof(atomic<unsigned>)];
+  atomic<unsigned> tail;             // Only written by the producer.
+  Entry buf[SIZE];
+
+  bool push (Entry e) {
+    unsigned t = tail.load(memory_order_relaxed);
+    if (t - head.load(memory_order_acquire) == SIZE) return false;
+    buf[t & (SIZE - 1)] = e;
+    tail.store(t + 1, memory_order_release);
+    return true;
+  }
+
+  bool pop (Entry& e) {
+    unsigned h = head.load(memory_order_relaxed);
+    if (h == tail.load(memory_order_acquire)) return false;
+    e = buf[h & (SIZE - 1)];
+    head.store(h + 1, memory_order_release);
+    return true;
+  }
+
+};
+
+
+/**
+ * Shared between the game and one player process. The semaphores only
+ * wake up the other side; the data goes through the shared regions.
+ */
+struct SecGame::Channel {
+  sem_t go;    // Posted by the game when a new state has been published.
+  sem_t done;  // Posted by the player when all its movements are in ring.
+  Ring ring;
+};
+
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "Ring needs address-free atomics.");
+
+
+void SecGame::publish (const Board& b, const Layout& l, char* shm) {
+  *(int*)shm = b.round_;
+  memcpy(shm + l.cells,       b.grid_.data(),        l.rows*l.cols*sizeof(Cell));
+  memcpy(shm + l.units,       b.unit_.data(),        l.nb_units*sizeof(Unit));
+  memcpy(shm + l.num_cities,  b.num_cities_.data(),  l.nb_players*sizeof(int));
+  memcpy(shm + l.total_score, b.total_score_.data(), l.nb_players*sizeof(int));
+  memcpy(shm + l.status,      b.cpu_status_.data(),  l.nb_players*sizeof(double));
+
+  // The delta starts with the size of each of its parts.
+  const Round_delta& d = b.delta_;
+  _my_assert((int)d.movements.size() <= l.nb_units
+             and (int)d.captures.size() <= l.nb_units
+             and (int)d.cities.size() <= l.nb_cities, "Delta too large.");
+  int* sizes = (int*)(shm + l.delta);
+  sizes[0] = d.movements.size();
+  sizes[1] = d.captures.size();
+  sizes[2] = d.cities.size();
+  memcpy(shm + l.movements, d.movements.data(), sizes[0]*sizeof(Movement));
+  memcpy(shm + l.captures,  d.captures.data(),  sizes[1]*sizeof(Capture));
+  memcpy(shm + l.changes,   d.cities.data(),    sizes[2]*sizeof(City_change));
+}
+
+
+void SecGame::publish_tables (const Board& b, const Layout& l, char* shm) {
+  int n = l.rows*l.cols;
+  int m = (l.rows + 2)*(l.cols + 2);
+  const vector< vector<int> >& d = *b.distances_;
+  for (int k = 0; k < CellTypeSize*UnitTypeSize; ++k)
+    memcpy(shm + l.distances + k*n*sizeof(int), d[k].data(), n*sizeof(int));
+  const vector< vector<int> >& lm = *b.landmarks_;
+  for (int k = 0; k < UnitTypeSize*Info::LANDMARKS; ++k)
+    memcpy(shm + l.landmarks + k*n*sizeof(int), lm[k].data(), n*sizeof(int));
+  const vector< vector<char> >& ps = *b.passable_;
+  for (int ut = 0; ut < UnitTypeSize; ++ut)
+    memcpy(shm + l.passable + ut*m, ps[ut].data(), m);
+}
+
+
+void SecGame::load_tables (Player* p, const Layout& l, const char* shm) {
+  int n = l.rows*l.cols;
+  int m = (l.rows + 2)*(l.cols + 2);
+  auto d = make_shared< vector< vector<int> > >(CellTypeSize*UnitTypeSize);
+  for (int k = 0; k < (int)d->size(); ++k) {
+    const int* x = (const int*)(shm + l.distances) + k*n;
+    (*d)[k].assign(x, x + n);
+  }
+  auto lm = make_shared< vector< vector<int> > >(UnitTypeSize*Info::LANDMARKS);
+  for (int k = 0; k < (int)lm->size(); ++k) {
+    const int* x = (const int*)(shm + l.landmarks) + k*n;
+    (*lm)[k].assign(x, x + n);
+  }
+  auto ps = make_shared< vector< vector<char> > >(UnitTypeSize);
+  for (int ut = 0; ut < UnitTypeSize; ++ut) {
+    const char* x = shm + l.passable + ut*m;
+    (*ps)[ut].assign(x, x + m);
+  }
+  p->distances_ = d;
+  p->landmarks_ = lm;
+  p->passable_ = ps;
+}
+
+
+void SecGame::load (Player* p, const Layout& l, const char* shm) {
+  *static_cast<Action*>(p) = Action();
+  p->round_ = *(const int*)shm;
+  const Cell* cells = (const Cell*)(shm + l.cells);
+  if (p->grid_.rows() != l.rows or p->grid_.cols() != l.cols)
+    p->grid_.assign(l.rows, l.cols);
+  p->grid_.copy_from(cells);
+  const Unit* units = (const Unit*)(shm + l.units);
+  p->unit_.assign(units, units + l.nb_units);
+  const int* nc = (const int*)(shm + l.num_cities);
+  p->num_cities_.assign(nc, nc + l.nb_players);
+  const int* ts = (const int*)(shm + l.total_score);
+  p->total_score_.assign(ts, ts + l.nb_players);
+  const double* st = (const double*)(shm + l.status);
+  p->cpu_status_.assign(st, st + l.nb_players);
+  const int* sizes = (const int*)(shm + l.delta);
+  const Movement* mv = (const Movement*)(shm + l.movements);
+  p->delta_.movements.assign(mv, mv + sizes[0]);
+  const Capture* cp = (const Capture*)(shm + l.captures);
+  p->delta_.captures.assign(cp, cp + sizes[1]);
+  const City_change* cc = (const City_change*)(shm + l.changes);
+  p->delta_.cities.assign(cc, cc + sizes[2]);
+  if (not p->distances_) load_tables(p, l, shm);
+  p->update_vectors_by_player();
+  ++p->plays_;
+  p->arena_.clear();
+}
+
+
+void SecGame::serve (Player* p, const Layout& l, const char* shm, Channel* ch) {
+  while (true) {
+    while (sem_wait(&ch->go) == -1 and errno == EINTR) ;
+    int round = *(const int*)shm;
+    if (round == -1) {
+      Log::flush();
+      _exit(EXIT_SUCCESS);
+    }
+
+    load(p, l, shm);
+    p->play();
+    Log::flush();
+
+    for (const Movement& m : p->v_)
+      while (not ch->ring.push(Entry{m.id, m.dir})) sched_yield();
+    while (not ch->ring.push(Entry{-1, round})) sched_yield();
+    sem_post(&ch->done);
+  }
+}
+
+
+/**
+ * Returns the cpu time consumed so far by a process, in seconds.
+ */
+static double process_cpu_time (int pid) {
+  clockid_t clock;
+  timespec ts = { 0, 0 };
+  if (clock_getcpuclockid(pid, &clock) == 0) clock_gettime(clock, &ts);
+  return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+
+/**
+ * Returns the wall time, in seconds from an arbitrary point.
+ */
+static double wall_time () {
+  return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+bool SecGame::collect (int pid, Channel* ch, int round, double start,
+                       double cpu_start, double& cpu,
+                       double cpu_limit, double round_limit, Action& act) {
+  bool finished = false;
+  while (not finished) {
+    // Drains the ring while waiting, so that the player never blocks on it.
+    Entry e;
+    while (not finished and ch->ring.pop(e)) {
+      if (e.id == -1) finished = (e.dir == round);
+      else if ((int)act.v_.size() < Action::MAX_MOVEMENTS
+               and dir_ok(Dir(e.dir)) and act.u_.insert(e.id).second)
+        act.v_.push_back(Movement(e.id, Dir(e.dir)));
+    }
+    if (finished) break;
+
+    if (waitpid(pid, 0, WNOHANG) != 0) return false; // crashed
+
+    double used = cpu + process_cpu_time(pid) - cpu_start;
+    if ((round_limit > 0 and wall_time() - start > round_limit)
+        or (cpu_limit > 0 and used > cpu_limit)) return false;
+
+    // Short waits, to notice crashes and overruns in time.
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 10*1000*1000;
+    if (ts.tv_nsec >= 1000*1000*1000) {
+      ++ts.tv_sec;
+      ts.tv_nsec -= 1000*1000*1000;
+    }
+    sem_timedwait(&ch->done, &ts);
+  }
+
+  while (sem_trywait(&ch->done) == 0) ;
+  cpu += process_cpu_time(pid) - cpu_start;
+  return cpu_limit <= 0 or cpu <= cpu_limit;
+}
+
+
+void SecGame::run (vector<string> names, istream& is, ostream& os, int seed,
+                   const Game_options& opt) {
+  _my_assert(opt.save_file.empty() and opt.resume_file.empty(),
+             "SecGame does not support checkpoints.");
+  double cpu_time = opt.cpu_time;
+  double round_time = opt.round_time;
+
+  _log_info(LogGame, "seed " << seed);
+
+  // The players are forked before the board exists, so that no process of
+  // a player holds the board, or its random generator, in its memory. Each
+  // one only builds its own player.
+  Settings settings = Settings::read_settings(is);
+  int np = settings.nb_players();
+  int nr = settings.nb_rounds();
+
+  _my_assert(np == (int)names.size(), "Wrong number of players.");
+
+  vector<Registry::Factory> factory;
+  for (const string& name : names) {
+    _log_info(LogGame, "loading player " << name);
+    factory.push_back(Registry::factory(name));
+  }
+  _log_info(LogGame, "players loaded");
+
+  // The state region is sealed, so that the players can only map it read-only.
+  Layout l(settings);
+  int fd = memfd_create("SecGame", MFD_ALLOW_SEALING);
+  _my_assert(fd != -1 and ftruncate(fd, l.size) == 0, "Cannot create shared state.");
+  char* shm = (char*)mmap(0, l.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  _my_assert(shm != MAP_FAILED, "Cannot map shared state.");
+  int seals = F_SEAL_SHRINK | F_SEAL_GROW;
+#ifdef F_SEAL_FUTURE_WRITE
+  seals |= F_SEAL_FUTURE_WRITE;
+#endif
+  fcntl(fd, F_ADD_SEALS, seals);
+
+  vector<Channel*> channel(np);
+  for (int pl = 0; pl < np; ++pl) {
+    void* p = mmap(0, sizeof(Channel), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    _my_assert(p != MAP_FAILED, "Cannot map player channel.");
+    channel[pl] = new (p) Channel();
+    sem_init(&channel[pl]->go, 1, 0);
+    sem_init(&channel[pl]->done, 1, 0);
+  }
+
+  // Nothing buffered may be written twice by the children.
+  os.flush();
+  cout.flush();
+  Log::flush();
+
+  vector<int> pid(np);
+  for (int pl = 0; pl < np; ++pl) {
+    pid[pl] = fork();
+    _my_assert(pid[pl] != -1, "Cannot fork player.");
+    if (pid[pl] == 0) {
+      prctl(PR_SET_PDEATHSIG, SIGKILL);
+      munmap(shm, l.size);
+      const char* ro = (const char*)mmap(0, l.size, PROT_READ, MAP_SHARED, fd, 0);
+      close(fd);
+      for (int q = 0; q < np; ++q)
+        if (q != pl) munmap(channel[q], sizeof(Channel));
+      if (ro == MAP_FAILED) _exit(EXIT_FAILURE);
+      Player* p = factory[pl]();
+      p->me_ = pl;
+      p->set_random_seed(seed + pl + 1);
+      *static_cast<Settings*>(p) = settings;
+      serve(p, l, ro, channel[pl]);
+    }
+  }
+  close(fd);
+
+  _log_info(LogGame, "loading game");
+  Board b(settings, is, seed);
+  for (int pl = 0; pl < np; ++pl) b.names_[pl] = names[pl];
+  publish_tables(b, l, shm);
+  _log_info(LogGame, "loaded game");
+
+  os << "Game" << endl << endl;
+  os << "Seed " << seed << endl << endl;
+  b.print_preamble(os);
+  b.print_names(os);
+  b.print_state(os);
+
+  // The trace of every round is written while the next one is played.
+  Output_stage out(os);
+  vector<Movement> done;
+  vector<double> cpu(np, 0);
+  for (int round = 0; round < nr; ++round) {
+    _log_debug(LogGame, "start round " << round);
+    publish(b, l, shm);
+    vector<double> cpu_start(np);
+    double start = wall_time();
+    for (int pl = 0; pl < np; ++pl)
+      if (b.cpu_status_[pl] >= 0) {
+        cpu_start[pl] = process_cpu_time(pid[pl]);
+        sem_post(&channel[pl]->go);
+      }
+
+    // All the players think at the same time.
+    vector<Action> actions(np);
+    for (int pl = 0; pl < np; ++pl)
+      if (b.cpu_status_[pl] >= 0) {
+        if (collect(pid[pl], channel[pl], round, start, cpu_start[pl], cpu[pl],
+                    cpu_time, round_time, actions[pl])) {
+          if (cpu_time > 0) b.cpu_status_[pl] = cpu[pl]/cpu_time;
+        }
+        else {
+          _log_warning(LogGame, "player " << pl << " crashed or exceeded its time limit");
+          kill(pid[pl], SIGKILL);
+          waitpid(pid[pl], 0, 0);
+          b.cpu_status_[pl] = -1;
+          actions[pl] = Action();
+        }
+      }
+
+    b.next(actions, done);
+    out.push(done, b);
+    _log_debug(LogGame, "end round " << round);
+  }
+
+  *(int*)shm = -1;
+  for (int pl = 0; pl < np; ++pl)
+    if (b.cpu_status_[pl] >= 0) {
+      sem_post(&channel[pl]->go);
+      waitpid(pid[pl], 0, 0);
+    }
+  for (int pl = 0; pl < np; ++pl) munmap(channel[pl], sizeof(Channel));
+  munmap(shm, l.size);
+
+  out.flush();
+  b.print_results();
+
+  _log_info(LogGame, "game played");
+}
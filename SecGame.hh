@@ -0,0 +1,79 @@
+#ifndef SecGame_hh
+#define SecGame_hh
+
+
+#include "Game.hh"
+
+
+/** \file
+ * Contains the secure version of the Game class, where every player runs
+ * in its own process.
+ */
+
+
+/**
+ * Secure game class.
+ *
+ * Each player is forked into its own process, and built there, before the
+ * board is, so that it cannot read the board (or its random generator) or
+ * the other players from its memory. Every round, the state of the board
+ * is published into a shared memory region that the players can only
+ * read, and their movements come back through a lock-free ring buffer in a
+ * second shared region, one per player. A player that crashes or exceeds
+ * its time limits is killed, and its status becomes -1.
+ */
+class SecGame {
+
+  struct Layout;
+  struct Channel;
+
+  /**
+   * Writes the state of the board into the shared region.
+   */
+  static void publish (const Board& b, const Layout& l, char* shm);
+
+  /**
+   * Writes the tables of the board that never change during a game into
+   * the shared region. Called once, before the first round.
+   */
+  static void publish_tables (const Board& b, const Layout& l, char* shm);
+
+  /**
+   * Loads the tables written by publish_tables into a player.
+   */
+  static void load_tables (Player* p, const Layout& l, const char* shm);
+
+  /**
+   * Loads the state in the shared region into a player.
+   */
+  static void load (Player* p, const Layout& l, const char* shm);
+
+  /**
+   * Main loop of a player process. Never returns.
+   */
+  static void serve (Player* p, const Layout& l, const char* shm, Channel* ch);
+
+  /**
+   * Waits for the movements of a player process and stores them in act.
+   * The round started at wall time start, when the process had used
+   * cpu_start seconds; cpu accumulates its cpu time in the game.
+   * Returns false if the process crashed or exceeded its time limits.
+   */
+  static bool collect (int pid, Channel* ch, int round, double start,
+                       double cpu_start, double& cpu,
+                       double cpu_limit, double round_limit, Action& act);
+
+public:
+
+  /**
+   * Plays a game. If cpu_time or round_time are positive, they limit the
+   * total cpu time of each player, and the wall time of each of its rounds.
+   * Checkpoints are not supported.
+   */
+  static void run (vector<string> names, istream& is, ostream& os, int seed,
+                   const Game_options& opt = Game_options());
+
+};
+
+
+#endif
@@ -0,0 +1,35 @@
+#include "Simulator.hh"
+#include "Board.hh"
+
+
+Simulator::Simulator () { }
+
+
+Simulator::~Simulator () { }
+
+
+const Info& Simulator::next (const Info& from, const vector<Action>& actions,
+                             int seed) {
+  if (not board_) board_.reset(new Board(from));
+  else if (board_.get() != &from) board_->assign(from);
+  board_->set_random_seed(seed);
+
+  int np = from.nb_players();
+  if ((int)actions.size() >= np) board_->next(actions, done_);
+  else {
+    actions_.resize(np);
+    for (int pl = 0; pl < np; ++pl)
+      actions_[pl] = pl < (int)actions.size() ? actions[pl] : Action();
+    board_->next(actions_, done_);
+  }
+  return *board_;
+}
+
+
+const Info& Simulator::next (const Info& from, int pl, const Action& action,
+                             int seed) {
+  int np = from.nb_players();
+  actions_.resize(np);
+  for (int q = 0; q < np; ++q) actions_[q] = q == pl ? action : Action();
+  return next(from, actions_, seed);
+}
@@ -0,0 +1,56 @@
+#ifndef Simulator_hh
+#define Simulator_hh
+
+
+#include "Info.hh"
+#include "Action.hh"
+
+
+/** \file
+ * Contains a class to play rounds on a private copy of the board.
+ */
+
+
+class Board;
+
+
+/**
+ * Plays rounds for the players, on a private board that is reused by every
+ * simulation, so that many candidate actions can be tried in each round.
+ *
+ * The rounds are played by the same code as the real ones (Board::next),
+ * so movements, fights and spawns follow the rules exactly. The random
+ * outcomes (the order of the movements, the fights decided at random and
+ * the owners of the killed units) are drawn from a generator with the
+ * given seed: the same seed gives the same round.
+ */
+class Simulator {
+
+  unique_ptr<Board> board_;
+  vector<Action> actions_;  // Actions padded to one per player.
+  vector<Movement> done_;
+
+public:
+
+  Simulator ();
+
+  ~Simulator ();
+
+  /**
+   * Plays a round from the state of from, with the actions of every
+   * player (indexed by player; missing players do nothing), and returns
+   * the resulting state. Its delta() tells what happened in the round.
+   * The result is valid until the next call, and can be passed as from,
+   * to simulate several rounds.
+   */
+  const Info& next (const Info& from, const vector<Action>& actions, int seed);
+
+  /**
+   * Same as above, when only player pl acts.
+   */
+  const Info& next (const Info& from, int pl, const Action& action, int seed);
+
+};
+
+
+#endif
@@ -1 +1,4 @@
 #include "State.hh"
+
+
+const vector<int> State::no_units_;
@@ -3,6 +3,11 @@
 
 
 #include "Structs.hh"
+#include "Action.hh"
+#include "Grid.hh"
+#include "Log.hh"
+
+#include <cstdint>
 
 
 /*! \file
@@ -10,6 +15,18 @@
  */
 
 
+/**
+ * What changed in a round.
+ */
+struct Round_delta {
+
+  vector<Movement> movements;     // Movements done, in the order they were done.
+  vector<Capture> captures;       // Units killed, in the order they were killed.
+  vector<City_change> cities;     // Cities that changed their owner.
+
+};
+
+
 /**
  * Stores the game state.
  */
@@ -19,9 +36,10 @@ class State {
   friend class Board;
   friend class Game;
   friend class SecGame;
+  friend class Bench;
   friend class Player;
 
-  vector< vector<Cell> > grid_;
+  Grid<Cell> grid_;
   int round_;
   vector<Unit> unit_;
   vector<int> num_cities_;
@@ -29,6 +47,16 @@ class State {
   vector<double> cpu_status_; // -1 -> dead, 0..1 -> % of cpu time limit
   vector< vector<int> > warriors_;
   vector< vector<int> > cars_;
+  vector<uint64_t> occupancy_;   // See Info::occupancy().
+  vector<int> bucket_start_;     // First unit of every bucket in bucket_units_.
+  vector<int> bucket_units_;     // Units sorted by bucket, and then by id.
+  vector<int> city_warriors_;    // See Info::city_warriors().
+  Round_delta delta_;
+
+  /**
+   * Returned by warriors() and cars() for a wrong player.
+   */
+  static const vector<int> no_units_;
 
   /**
    * Returns whether id is a valid unit identifier.
@@ -50,9 +78,8 @@ public:
    * Returns a copy of the cell at p.
    */
   inline Cell cell (Pos p) const {
-    if (p.i < 0 or p.i >= (int)grid_.size()
-        or p.j < 0 or p.j >= (int)grid_[p.i].size()) {
-      cerr << "warning: cell requested for position " << p << endl;
+    if (not grid_.pos_ok(p)) {
+      _log_warning(LogState, "cell requested for position " << p);
       return Cell();
     }
     return grid_[p.i][p.j];
@@ -65,6 +92,24 @@ public:
     return cell(Pos(i, j));
   }
 
+  /**
+   * Returns the cell at p, without copying it. Faster than cell(), but p
+   * must be a valid position: it is only checked when compiled with DEBUG.
+   */
+  inline const Cell& cell_ref (Pos p) const {
+#ifdef DEBUG
+    _my_assert(grid_.pos_ok(p), "cell_ref requested for a wrong position.");
+#endif
+    return grid_[p];
+  }
+
+  /**
+   * Same as above, for the cell at (i, j).
+   */
+  inline const Cell& cell_ref (int i, int j) const {
+    return cell_ref(Pos(i, j));
+  }
+
   /**
    * Returns the total number of units in the game.
    */
@@ -77,18 +122,29 @@ public:
    */
   inline Unit unit (int id) const {
     if (not unit_ok(id)) {
-      cerr << "warning: unit requested for identifier " << id << endl;
+      _log_warning(LogState, "unit requested for identifier " << id);
       return Unit();
     }
     return unit_[id];
   }
 
+  /**
+   * Returns the unit with identifier id, without copying it. Faster than
+   * unit(), but id must be valid: it is only checked when compiled with DEBUG.
+   */
+  inline const Unit& unit_ref (int id) const {
+#ifdef DEBUG
+    _my_assert(unit_ok(id), "unit_ref requested for a wrong identifier.");
+#endif
+    return unit_[id];
+  }
+
   /**
    * Returns the current number of cities owned by a player.
    */
   inline int num_cities (int pl) const {
     if (pl < 0 or pl >= (int)num_cities_.size()) {
-      cerr << "warning: score requested for player " << pl << endl;
+      _log_warning(LogState, "score requested for player " << pl);
       return -1;
     }
     return num_cities_[pl];
@@ -99,7 +155,7 @@ public:
    */
   inline int total_score (int pl) const {
     if (pl < 0 or pl >= (int)total_score_.size()) {
-      cerr << "warning: total score requested for player " << pl << endl;
+      _log_warning(LogState, "total score requested for player " << pl);
       return -1;
     }
     return total_score_[pl];
@@ -108,38 +164,50 @@ public:
   /**
    * Returns the percentage of cpu time used in the last round, in the
    * range [0.0 - 1.0] or a value lesser than 0 if this player is dead.
-   * Note that this is only accessible if secgame() is true.
+   * Note that this is only computed when the players run under a time
+   * limit (see Watchdog), otherwise it is 0.
    */
   inline double status (int pl) const {
     if (pl < 0 or pl >= (int)cpu_status_.size()) {
-      cerr << "warning: status requested for player " << pl << endl;
+      _log_warning(LogState, "status requested for player " << pl);
       return -2;
     }
     return cpu_status_[pl];
   }
 
   /**
-   * Returns the ids of all the warriors of a player.
+   * Returns the ids of all the warriors of a player. The list is not copied,
+   * and stays valid until the state changes.
    */
-  inline vector<int> warriors (int pl) const {
+  inline const vector<int>& warriors (int pl) const {
     if (pl < 0 or pl >= (int)num_cities_.size()) {
-      cerr << "warning: warriors requested for player " << pl << endl;
-      return vector<int>();
+      _log_warning(LogState, "warriors requested for player " << pl);
+      return no_units_;
     }
     return warriors_[pl];
   }
 
   /**
-   * Returns the ids of all the cars of a player.
+   * Returns the ids of all the cars of a player. The list is not copied,
+   * and stays valid until the state changes.
    */
-  inline vector<int> cars (int pl) const {
+  inline const vector<int>& cars (int pl) const {
     if (pl < 0 or pl >= (int)num_cities_.size()) {
-      cerr << "warning: cars requested for player " << pl << endl;
-      return vector<int>();
+      _log_warning(LogState, "cars requested for player " << pl);
+      return no_units_;
     }
     return cars_[pl];
   }
 
+  /**
+   * Returns what changed in the last round, so that players can update
+   * their own structures instead of computing them again. Empty before the
+   * first round, and in the first round after resuming a game.
+   */
+  inline const Round_delta& delta () const {
+    return delta_;
+  }
+
   /**
    * Tells if a unit can move at this round.
    */
@@ -148,7 +216,7 @@ public:
     const Unit& u = unit_[id];
     if (u.player == round()%4) return true;
     if (u.type == Warrior) return false;
-    return u.food > 0 and cell(u.pos).type == Road;
+    return u.food > 0 and grid_[u.pos.i][u.pos.j].type == Road;
   }
 
 };
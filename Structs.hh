@@ -221,4 +221,30 @@ struct Unit {
 };
 
 
+/**
+ * A unit that was killed in a round, and respawned for its new owner.
+ */
+struct Capture {
+
+  int id;          // The unit.
+  int old_player;  // Its owner before the round.
+  int new_player;  // Its owner after the round.
+  Pos old_pos;     // Where it was killed.
+  Pos new_pos;     // Where it respawned.
+
+};
+
+
+/**
+ * A city that changed its owner in a round.
+ */
+struct City_change {
+
+  int city;        // The city, as numbered by Info::cities().
+  int old_owner;
+  int new_owner;
+
+};
+
+
 #endif
@@ -60,4 +60,14 @@ inline int string_to_int (const string& s) {
     return i;
 }
 
+/**
+ * Same as string_to_int, for doubles.
+ */
+inline double string_to_double (const string& s) {
+  istringstream iss(s);
+  double d;
+  iss >> d;
+  return d;
+}
+
 #endif
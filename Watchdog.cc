@@ -0,0 +1,184 @@
+#include "Watchdog.hh"
+
+#include <csignal>
+#include <chrono>
+#include <sched.h>
+
+
+atomic<int> Watchdog::runaway_(0);
+
+
+/**
+ * Where a crashing worker jumps to. Null outside guarded_play().
+ */
+static thread_local sigjmp_buf* crash_jump_ = 0;
+
+
+/**
+ * Handler for the signals raised by a crashing player. Outside a worker,
+ * the signal gets its default behaviour.
+ */
+static void on_crash (int sig) {
+  if (crash_jump_) siglongjmp(*crash_jump_, sig);
+  signal(sig, SIG_DFL);
+  raise(sig);
+}
+
+
+static const int CRASH_SIGNALS[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+
+
+Watchdog::Watchdog (int nb_players, double cpu_limit, double round_limit)
+  : cpu_limit_(cpu_limit), round_limit_(round_limit),
+    worker_(nb_players), cpu_used_(nb_players, 0) {
+
+  struct sigaction sa;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = on_crash;
+  sa.sa_flags = SA_ONSTACK; // Also handles stack overflows.
+  sigemptyset(&sa.sa_mask);
+  for (int sig : CRASH_SIGNALS) sigaction(sig, &sa, 0);
+
+  for (int pl = 0; pl < nb_players; ++pl) {
+    Worker* w = worker_[pl] = new Worker();
+    w->p = 0;
+    w->go = w->done = w->crashed = w->quit = false;
+    w->th = thread(work, w);
+    pthread_getcpuclockid(w->th.native_handle(), &w->clock);
+  }
+}
+
+
+Watchdog::~Watchdog () {
+  for (Worker* w : worker_)
+    if (w) {
+      {
+        lock_guard<mutex> lock(w->m);
+        w->quit = true;
+      }
+      w->cv.notify_all();
+      w->th.join();
+      delete w;
+    }
+}
+
+
+void Watchdog::work (Worker* w) {
+  // Signals are handled on a separate stack, so that a player
+  // that overflows its own stack can still be caught.
+  vector<char> alt(1 << 16);
+  stack_t ss;
+  ss.ss_sp = alt.data();
+  ss.ss_size = alt.size();
+  ss.ss_flags = 0;
+  sigaltstack(&ss, 0);
+
+  unique_lock<mutex> lock(w->m);
+  while (true) {
+    w->cv.wait(lock, [w] { return w->go or w->quit; });
+    if (w->quit) return;
+    w->go = false;
+    Player* p = w->p;
+    lock.unlock();
+
+    bool ok = guarded_play(p);
+
+    lock.lock();
+    w->crashed = not ok;
+    w->done = true;
+    w->cv.notify_all();
+    if (not ok) return;
+  }
+}
+
+
+bool Watchdog::guarded_play (Player* p) {
+  sigjmp_buf env;
+  if (sigsetjmp(env, 1)) {
+    crash_jump_ = 0;
+    return false;
+  }
+  crash_jump_ = &env;
+  try {
+    p->play();
+  }
+  catch (...) {
+    crash_jump_ = 0;
+    return false;
+  }
+  crash_jump_ = 0;
+  return true;
+}
+
+
+double Watchdog::cpu_time (const Worker* w) {
+  timespec ts = { 0, 0 };
+  clock_gettime(w->clock, &ts);
+  return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+
+double Watchdog::play (Player* p, int pl) {
+  Worker* w = worker_[pl];
+  if (w == 0) return -1;
+
+  typedef chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+  double cpu_start = cpu_time(w);
+
+  unique_lock<mutex> lock(w->m);
+  w->p = p;
+  w->done = false;
+  w->go = true;
+  w->cv.notify_all();
+
+  bool overrun = false;
+  while (not w->done and not overrun) {
+    // Waits for as long as neither limit can have been reached yet:
+    // the cpu time of the worker never grows faster than the wall time.
+    double slice = 1e9;
+    double wall = chrono::duration<double>(Clock::now() - start).count();
+    double cpu = cpu_used_[pl] + cpu_time(w) - cpu_start;
+    if (round_limit_ > 0) slice = min(slice, round_limit_ - wall);
+    if (cpu_limit_ > 0) slice = min(slice, cpu_limit_ - cpu);
+
+    if (slice <= 0) overrun = true;
+    else if (slice >= 1e9) w->cv.wait(lock);
+    else w->cv.wait_for(lock, chrono::duration<double>(slice));
+  }
+
+  if (not w->done) {
+    _log_warning(LogGame, "player " << pl << " exceeded its time limit");
+    lock.unlock();
+    sched_param sp;
+    sp.sched_priority = 0;
+    pthread_setschedparam(w->th.native_handle(), SCHED_IDLE, &sp);
+    w->th.detach(); // The Worker is leaked on purpose: the thread still uses it.
+    worker_[pl] = 0;
+    ++runaway_;
+    return -1;
+  }
+
+  if (w->crashed) {
+    _log_warning(LogGame, "player " << pl << " crashed");
+    lock.unlock();
+    w->th.join();
+    delete w;
+    worker_[pl] = 0;
+    return -1;
+  }
+
+  cpu_used_[pl] += cpu_time(w) - cpu_start;
+  if (cpu_limit_ <= 0) return 0;
+  if (cpu_used_[pl] > cpu_limit_) {
+    _log_warning(LogGame, "player " << pl << " exceeded its time limit");
+    worker_[pl] = 0;
+    w->quit = true;
+    w->cv.notify_all();
+    lock.unlock();
+    w->th.join();
+    delete w;
+    return -1;
+  }
+  return cpu_used_[pl]/cpu_limit_;
+}
@@ -0,0 +1,105 @@
+#ifndef Watchdog_hh
+#define Watchdog_hh
+
+
+#include "Player.hh"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <csetjmp>
+#include <pthread.h>
+
+
+/** \file
+ * Contains a class to run the players under time limits, so that a player
+ * that runs for too long or crashes does not stop the whole game.
+ */
+
+
+/**
+ * Runs the play() method of every player in its own thread and watches it.
+ *
+ * A player that exceeds its total cpu time, or the wall time allowed for a
+ * single round, is abandoned: a thread cannot be stopped from outside, so
+ * it is left running on its own, with the lowest scheduling priority so
+ * that it only gets the cpu time that the others leave, and the player is
+ * never used again. Such threads only end with the process, which must
+ * then end with _exit() (see runaway()). A player that crashes
+ * (segmentation fault, failed assertion, uncaught exception...) is
+ * abandoned too, but its thread ends.
+ */
+class Watchdog {
+
+  /**
+   * A thread that runs the play() method of one player when asked to.
+   */
+  struct Worker {
+    thread th;
+    clockid_t clock;        // Cpu time clock of the thread.
+    mutex m;
+    condition_variable cv;
+    Player* p;
+    bool go;                // Set by the watchdog to start a play().
+    bool done;              // Set by the worker when play() returns.
+    bool crashed;           // Set by the worker if play() crashed.
+    bool quit;              // Set by the watchdog to end the thread.
+  };
+
+  double cpu_limit_;        // Total cpu seconds per player, <= 0 for none.
+  double round_limit_;      // Wall seconds per play(), <= 0 for none.
+  vector<Worker*> worker_;  // Null for dead players.
+  vector<double> cpu_used_;
+
+  static atomic<int> runaway_; // Threads left running in the process.
+
+  /**
+   * Main loop of a worker thread.
+   */
+  static void work (Worker* w);
+
+  /**
+   * Calls p->play(), returning false if it crashed.
+   */
+  static bool guarded_play (Player* p);
+
+  /**
+   * Returns the cpu time consumed so far by a worker, in seconds.
+   */
+  static double cpu_time (const Worker* w);
+
+public:
+
+  /**
+   * Creates the watchdog and starts one worker per player.
+   */
+  Watchdog (int nb_players, double cpu_limit, double round_limit);
+
+  /**
+   * Stops the workers that are still alive.
+   */
+  ~Watchdog ();
+
+  /**
+   * Runs p->play() for player pl under the limits. Returns the fraction
+   * of the cpu time limit used so far (0 if there is none), or -1 if the
+   * player is dead, in which case p must not be used anymore.
+   */
+  double play (Player* p, int pl);
+
+  /**
+   * Returns the number of threads left running by the watchdogs of the
+   * process, for players that exceeded their time limit. If there is any,
+   * the process must end with _exit(), after flushing its output, so that
+   * they do not run while the static objects (such as the log) are being
+   * destroyed.
+   */
+  static int runaway () {
+    return runaway_;
+  }
+
+};
+
+
+#endif
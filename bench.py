@@ -0,0 +1,168 @@
+import argparse
+import math
+import subprocess
+import sys
+
+# Records the results of ./Bench in a baseline file, and compares a new run
+# against a baseline.
+#
+#   python3 bench.py record bench.baseline [-n 10]
+#   python3 bench.py compare bench.baseline [--input new.tsv] [-n 10]
+#
+# Options not listed here (as -n or -f) are passed to ./Bench.
+# A benchmark regresses when it is slower than the baseline by more than the
+# threshold, and the difference of means is significant (Welch's t-test).
+# compare exits with status 1 if any benchmark regresses.
+
+
+def run_bench(args):
+  p = subprocess.run(["./Bench"] + args, stdout=subprocess.PIPE,
+                     universal_newlines=True, check=True)
+  return p.stdout
+
+
+def parse(text):
+  res = {}
+  for line in text.splitlines():
+    if line == "" or line.startswith("#"):
+      continue
+    f = line.split("\t")
+    res[f[0]] = {"unit": f[1], "n": int(f[2]), "median": float(f[3]),
+                 "mean": float(f[4]), "stddev": float(f[5])}
+  return res
+
+
+def betacf(a, b, x):
+  # Continued fraction of the incomplete beta function (Lentz's method).
+  tiny = 1e-300
+  c = 1.0
+  d = 1.0 - (a + b)*x/(a + 1)
+  if abs(d) < tiny:
+    d = tiny
+  d = 1.0/d
+  h = d
+  for m in range(1, 300):
+    m2 = 2*m
+    aa = m*(b - m)*x/((a + m2 - 1)*(a + m2))
+    d = 1.0 + aa*d
+    if abs(d) < tiny:
+      d = tiny
+    c = 1.0 + aa/c
+    if abs(c) < tiny:
+      c = tiny
+    d = 1.0/d
+    h *= d*c
+    aa = -(a + m)*(a + b + m)*x/((a + m2)*(a + m2 + 1))
+    d = 1.0 + aa*d
+    if abs(d) < tiny:
+      d = tiny
+    c = 1.0 + aa/c
+    if abs(c) < tiny:
+      c = tiny
+    d = 1.0/d
+    delta = d*c
+    h *= delta
+    if abs(delta - 1.0) < 1e-12:
+      break
+  return h
+
+
+def betainc(a, b, x):
+  # Regularized incomplete beta function I_x(a, b).
+  if x <= 0:
+    return 0.0
+  if x >= 1:
+    return 1.0
+  lbeta = math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+  front = math.exp(lbeta + a*math.log(x) + b*math.log(1 - x))
+  if x < (a + 1)/(a + b + 2):
+    return front*betacf(a, b, x)/a
+  return 1.0 - front*betacf(b, a, 1 - x)/b
+
+
+def welch(x, y):
+  # Two-sided p-value of Welch's t-test on the means of two benchmarks.
+  vx = x["stddev"]**2/x["n"]
+  vy = y["stddev"]**2/y["n"]
+  if vx + vy == 0:
+    return 0.0 if x["mean"] != y["mean"] else 1.0
+  t = (x["mean"] - y["mean"])/math.sqrt(vx + vy)
+  if x["n"] < 2 or y["n"] < 2:
+    return 1.0
+  df = (vx + vy)**2/(vx**2/(x["n"] - 1) + vy**2/(y["n"] - 1))
+  return betainc(df/2, 0.5, df/(df + t*t))
+
+
+def speedup(base, new):
+  # Greater than 1 when new is better. Units per second are better when higher.
+  if new["median"] == 0 or base["median"] == 0:
+    return 1.0
+  if base["unit"].endswith("/s"):
+    return new["median"]/base["median"]
+  return base["median"]/new["median"]
+
+
+def compare(base, new, threshold, alpha):
+  regressions = 0
+  print("%-24s %-9s %14s %14s %9s %9s  %s"
+        % ("benchmark", "unit", "baseline", "new", "speedup", "p-value", "verdict"))
+  for name in sorted(set(base) | set(new)):
+    if name not in base or name not in new:
+      print("%-24s %s" % (name, "only in baseline" if name in base else "new benchmark"))
+      continue
+    b = base[name]
+    n = new[name]
+    s = speedup(b, n)
+    p = welch(b, n)
+    verdict = ""
+    if p < alpha:
+      if s < 1 - threshold/100.0:
+        verdict = "REGRESSION"
+        regressions += 1
+      elif s > 1 + threshold/100.0:
+        verdict = "faster"
+      elif s < 1:
+        verdict = "slower"
+    print("%-24s %-9s %14.6g %14.6g %8.3fx %9.4f  %s"
+          % (name, b["unit"], b["median"], n["median"], s, p, verdict))
+  return regressions
+
+
+def main():
+  parser = argparse.ArgumentParser(description="Record and compare benchmark baselines.",
+                                   allow_abbrev=False)
+  parser.add_argument("command", choices=["record", "compare"])
+  parser.add_argument("baseline", help="baseline file")
+  parser.add_argument("--input", help="compare these results instead of running ./Bench")
+  parser.add_argument("--threshold", type=float, default=5.0,
+                      help="slowdown (in %%) allowed before failing (default: 5)")
+  parser.add_argument("--alpha", type=float, default=0.05,
+                      help="significance level (default: 0.05)")
+  opt, bench_args = parser.parse_known_args()
+
+  if opt.command == "record":
+    text = run_bench(bench_args)
+    with open(opt.baseline, "w") as f:
+      f.write(text)
+    sys.stdout.write(text)
+    return 0
+
+  with open(opt.baseline) as f:
+    base = parse(f.read())
+  if opt.input:
+    with open(opt.input) as f:
+      new = parse(f.read())
+  else:
+    new = parse(run_bench(bench_args))
+
+  regressions = compare(base, new, opt.threshold, opt.alpha)
+  if regressions > 0:
+    print("")
+    print(str(regressions) + " benchmark(s) regressed by more than "
+          + str(opt.threshold) + "%")
+    return 1
+  return 0
+
+
+if __name__ == "__main__":
+  sys.exit(main())